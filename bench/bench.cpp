@@ -0,0 +1,266 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <ctime>
+#include <omp.h>
+
+#include "../src/arg_parser.h"
+#include "../src/scheme_reducer.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct BenchStrategy {
+    std::string name;
+    Strategy strategy;
+};
+
+std::vector<std::string> split(const std::string &value, char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream ss(value);
+    std::string part;
+
+    while (std::getline(ss, part, delimiter))
+        if (part != "")
+            parts.push_back(part);
+
+    return parts;
+}
+
+std::string getSchemeName(const std::string &path) {
+    size_t start = path.find_last_of('/');
+    start = start == std::string::npos ? 0 : start + 1;
+
+    size_t end = path.find_last_of('.');
+    if (end == std::string::npos || end < start)
+        end = path.size();
+
+    return path.substr(start, end - start);
+}
+
+double getSeconds(Clock::time_point t1, Clock::time_point t2) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1e9;
+}
+
+std::vector<int> getThreadCounts(const std::string &value) {
+    std::vector<int> threads;
+
+    if (value != "0") {
+        for (const auto &part : split(value, ','))
+            threads.push_back(std::stoi(part));
+
+        return threads;
+    }
+
+    int maxThreads = omp_get_max_threads();
+    for (int count = 1; count < maxThreads; count *= 2)
+        threads.push_back(count);
+
+    threads.push_back(maxThreads);
+    return threads;
+}
+
+class Benchmark {
+    std::ostream &os;
+    std::string scheme;
+    std::string header;
+public:
+    Benchmark(std::ostream &os, const std::string &scheme, int seed) : os(os), scheme(scheme) {
+        std::stringstream ss;
+        ss << "\"timestamp\": " << time(0) << ", \"seed\": " << seed << ", \"max_threads\": " << omp_get_max_threads() << ", \"scheme\": \"" << scheme << "\"";
+        header = ss.str();
+    }
+
+    void strategies(const SchemeReducer &schemeReducer, const std::vector<BenchStrategy> &strategies, int runs, int seed) {
+        const char *names[] = {"u", "v", "w"};
+
+        for (const auto &strategy : strategies) {
+            for (int j = 0; j < 3; j++) {
+                RandomGenerator generator(seed);
+                AdditionReducer reducer;
+
+                long steps = 0;
+                double seconds = 0;
+                int minAdditions = schemeReducer.getInit(j).getNaiveAdditions();
+                double meanAdditions = 0;
+
+                for (int run = 0; run < runs; run++) {
+                    reducer.copyFrom(schemeReducer.getInit(j));
+                    reducer.setStrategy(strategy.strategy);
+
+                    auto t1 = Clock::now();
+                    reducer.reduce(generator);
+                    auto t2 = Clock::now();
+
+                    steps += reducer.getFreshVars();
+                    seconds += getSeconds(t1, t2);
+                    minAdditions = std::min(minAdditions, reducer.getAdditions());
+                    meanAdditions += reducer.getAdditions();
+                }
+
+                meanAdditions /= runs;
+
+                os << "{" << header << ", \"benchmark\": \"strategy\", \"component\": \"" << names[j] << "\", \"strategy\": \"" << strategy.name << "\"";
+                os << ", \"runs\": " << runs << ", \"steps\": " << steps << ", \"seconds\": " << seconds;
+                os << ", \"steps_per_sec\": " << (seconds > 0 ? steps / seconds : 0);
+                os << ", \"naive_additions\": " << schemeReducer.getInit(j).getNaiveAdditions();
+                os << ", \"min_additions\": " << minAdditions << ", \"mean_additions\": " << meanAdditions << "}" << std::endl;
+
+                std::cout << "- " << scheme << " " << names[j] << " " << strategy.name << ": " << steps / seconds << " steps/sec, min additions: " << minAdditions << std::endl;
+            }
+        }
+    }
+
+    void initialization(const SchemeReducer &schemeReducer, int repeats, int seed) {
+        const char *names[] = {"u", "v", "w"};
+
+        for (int j = 0; j < 3; j++) {
+            RandomGenerator generator(seed);
+            AdditionReducer best;
+            AdditionReducer reducer;
+
+            best.copyFrom(schemeReducer.getInit(j));
+            best.setStrategy(Strategy::Greedy);
+            best.reduce(generator);
+
+            size_t prefix = best.getFreshVars() * 3 / 4;
+            double copySeconds = 0;
+            double partialSeconds = 0;
+
+            for (int repeat = 0; repeat < repeats; repeat++) {
+                auto t1 = Clock::now();
+                reducer.copyFrom(schemeReducer.getInit(j));
+                auto t2 = Clock::now();
+                reducer.partialInitialize(best, prefix);
+                auto t3 = Clock::now();
+
+                copySeconds += getSeconds(t1, t2);
+                partialSeconds += getSeconds(t2, t3);
+            }
+
+            os << "{" << header << ", \"benchmark\": \"initialization\", \"component\": \"" << names[j] << "\"";
+            os << ", \"repeats\": " << repeats << ", \"prefix\": " << prefix;
+            os << ", \"copy_from_ns\": " << copySeconds / repeats * 1e9;
+            os << ", \"partial_initialize_ns\": " << partialSeconds / repeats * 1e9 << "}" << std::endl;
+
+            std::cout << "- " << scheme << " " << names[j] << " copyFrom / partialInitialize: " << copySeconds / repeats * 1e9 << " / " << partialSeconds / repeats * 1e9 << " ns" << std::endl;
+        }
+    }
+
+    void iterations(const std::string &path, const std::vector<int> &threads, int count, int iterations, double partialInitializationRate, int seed) {
+        for (int threadsCount : threads) {
+            omp_set_num_threads(threadsCount);
+
+            std::ifstream f(path);
+            SchemeReducer reducer(count, "", StrategyWeights(), seed);
+            std::streambuf *buffer = std::cout.rdbuf(nullptr);
+            bool correct = reducer.initialize(f);
+            std::cout.rdbuf(buffer);
+
+            if (!correct)
+                return;
+
+            double total = 0;
+            double minTime = 0;
+
+            for (int iteration = 1; iteration <= iterations; iteration++) {
+                auto t1 = Clock::now();
+                reducer.reduceIteration(iteration, partialInitializationRate);
+                auto t2 = Clock::now();
+
+                double elapsed = getSeconds(t1, t2);
+                total += elapsed;
+                minTime = iteration == 1 ? elapsed : std::min(minTime, elapsed);
+            }
+
+            os << "{" << header << ", \"benchmark\": \"iteration\", \"threads\": " << threadsCount << ", \"count\": " << count;
+            os << ", \"iterations\": " << iterations << ", \"mean_seconds\": " << total / iterations << ", \"min_seconds\": " << minTime << "}" << std::endl;
+
+            std::cout << "- " << scheme << " reduceIteration with " << threadsCount << " threads: " << total / iterations << " sec" << std::endl;
+        }
+    }
+};
+
+int main(int argc, char *argv[]) {
+    ArgParser parser("ternary_addition_reducer_bench", "Run fixed seed benchmarks of the addition reducers on the reference schemes");
+
+    parser.add("--schemes", ArgType::String, "PATHS", "comma separated paths to reference schemes", "bench/schemes/2x2x2_m7.txt,bench/schemes/3x3x3_m23.txt,bench/schemes/4x4x4_m49.txt,bench/schemes/4x4x8_m98.txt");
+    parser.add("-o", ArgType::String, "PATH", "path to append benchmark results (JSON lines)", "bench_results.jsonl");
+    parser.add("--runs", ArgType::Natural, "INT", "number of reducer runs per strategy and component", "4");
+    parser.add("--repeats", ArgType::Natural, "INT", "number of repeats for copyFrom / partialInitialize timing", "1000");
+    parser.add("--count", ArgType::Natural, "INT", "number of reducers for reduceIteration timing", "8");
+    parser.add("--iterations", ArgType::Natural, "INT", "number of reduceIteration calls per thread count", "3");
+    parser.add("--threads", ArgType::String, "LIST", "comma separated thread counts for reduceIteration timing (0 - powers of two up to max)", "0");
+    parser.add("--seed", ArgType::Natural, "INT", "random seed", "42");
+
+    if (!parser.parse(argc, argv))
+        return 0;
+
+    std::vector<std::string> paths = split(parser.get("--schemes"), ',');
+    std::string outputPath = parser.get("-o");
+    int runs = std::stoi(parser.get("--runs"));
+    int repeats = std::stoi(parser.get("--repeats"));
+    int count = std::stoi(parser.get("--count"));
+    int iterations = std::stoi(parser.get("--iterations"));
+    std::vector<int> threads = getThreadCounts(parser.get("--threads"));
+    int seed = std::stoi(parser.get("--seed"));
+
+    if (runs == 0 || repeats == 0 || count == 0 || iterations == 0) {
+        std::cout << "Runs, repeats, count and iterations must be positive" << std::endl;
+        return -1;
+    }
+
+    std::vector<BenchStrategy> strategies = {
+        {"g", Strategy::Greedy},
+        {"ga", Strategy::GreedyAlternative},
+        {"gr", Strategy::GreedyRandom},
+        {"wr", Strategy::WeightedRandom},
+        {"gi", Strategy::GreedyIntersections},
+        {"gp", Strategy::GreedyPotential},
+        {"bs", Strategy::BeamSearch},
+        {"mix", Strategy::Mix}
+    };
+
+    std::ofstream output(outputPath, std::ios::app);
+    if (!output) {
+        std::cout << "Unable to open file \"" << outputPath << "\"" << std::endl;
+        return -1;
+    }
+
+    int maxThreads = omp_get_max_threads();
+
+    for (const auto &path : paths) {
+        std::ifstream f(path);
+        if (!f) {
+            std::cout << "Unable to open file \"" << path << "\"" << std::endl;
+            return -1;
+        }
+
+        omp_set_num_threads(maxThreads);
+        SchemeReducer schemeReducer(1, "", StrategyWeights(), seed);
+        std::streambuf *buffer = std::cout.rdbuf(nullptr);
+        bool correct = schemeReducer.initialize(f);
+        std::cout.rdbuf(buffer);
+        f.close();
+
+        if (!correct) {
+            std::cout << "Scheme \"" << path << "\" is invalid" << std::endl;
+            return -1;
+        }
+
+        std::string name = getSchemeName(path);
+        std::cout << "Benchmark " << name << ":" << std::endl;
+
+        Benchmark benchmark(output, name, seed);
+        benchmark.strategies(schemeReducer, strategies, runs, seed);
+        benchmark.initialization(schemeReducer, repeats, seed);
+        benchmark.iterations(path, threads, count, iterations, 0.3, seed);
+        std::cout << std::endl;
+    }
+
+    omp_set_num_threads(maxThreads);
+    std::cout << "Benchmark results appended to \"" << outputPath << "\"" << std::endl;
+    return 0;
+}
@@ -0,0 +1,116 @@
+#include <iostream>
+#include <string>
+#include <vector>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
+#include <random>
+
+#include "../src/arg_parser.h"
+#include "../src/random_generator.h"
+
+#ifndef KERNEL
+#error "path to generated kernel must be set by -DKERNEL"
+#endif
+
+#include KERNEL
+
+typedef std::chrono::high_resolution_clock Clock;
+
+template <typename T>
+double measure(int runs, T function) {
+    double best = 0;
+
+    for (int run = 0; run < runs; run++) {
+        auto t1 = Clock::now();
+        function();
+        auto t2 = Clock::now();
+
+        double elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1e9;
+        if (run == 0 || elapsed < best)
+            best = elapsed;
+    }
+
+    return best;
+}
+
+template <typename T>
+bool check(const std::string &type, size_t m, size_t k, size_t n, int runs, double tolerance, uint64_t seed) {
+    size_t rows = reduced_scheme::n1 * m;
+    size_t inner = reduced_scheme::n2 * k;
+    size_t columns = reduced_scheme::n3 * n;
+
+    std::vector<T> a(rows * inner);
+    std::vector<T> b(inner * columns);
+    std::vector<T> expected(rows * columns);
+    std::vector<T> result(rows * columns);
+
+    RandomGenerator generator(seed);
+    std::uniform_real_distribution<double> distribution(-1.0, 1.0);
+
+    for (auto &value : a)
+        value = distribution(generator);
+
+    for (auto &value : b)
+        value = distribution(generator);
+
+    double naiveTime = measure(runs, [&]() {
+        reduced_scheme::gemm(expected.data(), a.data(), b.data(), rows, inner, columns);
+    });
+
+    double schemeTime = measure(runs, [&]() {
+        reduced_scheme::multiply(a.data(), b.data(), result.data(), m, k, n);
+    });
+
+    double error = 0;
+    double scale = 0;
+
+    for (size_t i = 0; i < result.size(); i++) {
+        error = std::max(error, std::fabs((double) result[i] - (double) expected[i]));
+        scale = std::max(scale, std::fabs((double) expected[i]));
+    }
+
+    double relative = error / std::max(scale, 1e-300);
+    double flops = 2.0 * rows * inner * columns;
+    bool correct = relative <= tolerance;
+
+    std::cout << "- " << type << " " << rows << "x" << inner << "x" << columns << ": ";
+    std::cout << "naive " << flops / naiveTime / 1e9 << " GFLOP/s, scheme " << flops / schemeTime / 1e9 << " GFLOP/s, ";
+    std::cout << "speedup " << naiveTime / schemeTime << ", relative error " << relative << (correct ? "" : " (FAILED)") << std::endl;
+    return correct;
+}
+
+int main(int argc, char *argv[]) {
+    ArgParser parser("ternary_addition_kernel", "Check and measure generated block multiplication kernel");
+    parser.add("--sizes", ArgType::String, "LIST", "comma separated block sizes (m = k = n)", "16,64,128");
+    parser.add("--runs", ArgType::Natural, "INT", "number of runs, the best time is reported", "5");
+    parser.add("--seed", ArgType::Natural, "INT", "random seed", "42");
+
+    if (!parser.parse(argc, argv))
+        return 0;
+
+    std::vector<size_t> sizes;
+    std::string value = parser.get("--sizes");
+
+    for (size_t start = 0, end; start < value.size(); start = end + 1) {
+        end = value.find(',', start);
+        if (end == std::string::npos)
+            end = value.size();
+
+        if (end > start)
+            sizes.push_back(std::stoul(value.substr(start, end - start)));
+    }
+
+    int runs = std::stoi(parser.get("--runs"));
+    uint64_t seed = std::stoull(parser.get("--seed"));
+    bool correct = true;
+
+    std::cout << "Kernel " << reduced_scheme::n1 << "x" << reduced_scheme::n2 << "x" << reduced_scheme::n3 << " with " << reduced_scheme::rank << " multiplications and " << reduced_scheme::additions << " block additions" << std::endl;
+
+    for (size_t size : sizes) {
+        correct &= check<double>("double", size, size, size, runs, 1e-12, seed);
+        correct &= check<float>("float", size, size, size, runs, 1e-4, seed);
+    }
+
+    return correct ? 0 : 1;
+}
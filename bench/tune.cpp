@@ -0,0 +1,297 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <tuple>
+#include <chrono>
+#include <algorithm>
+#include <random>
+#include <climits>
+#include <omp.h>
+
+#include "../src/arg_parser.h"
+#include "../src/scheme_reducer.h"
+#include "../src/tuning_profile.h"
+#include "../src/reducer_options.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+// one point of the search space: options of the reducer chosen by hand before
+struct TuneConfig {
+    double greedyAlternative;
+    double greedyIntersections;
+    double partialInitializationRate;
+    int count;
+    int maxNoImprovements;
+    double score;
+    double seconds;
+
+    std::tuple<double, double, double, int, int> getKey() const {
+        return std::make_tuple(greedyAlternative, greedyIntersections, partialInitializationRate, count, maxNoImprovements);
+    }
+
+    ProfileOptions getOptions() const {
+        return {
+            {"--ga-weight", toString(greedyAlternative)},
+            {"--gi-weight", toString(greedyIntersections)},
+            {"--part-initialization-rate", toString(partialInitializationRate)},
+            {"--count", std::to_string(count)},
+            {"--max-no-improvements", std::to_string(maxNoImprovements)}
+        };
+    }
+
+    static std::string toString(double value) {
+        std::stringstream ss;
+        ss << value;
+        return ss.str();
+    }
+};
+
+struct TuneScheme {
+    std::string name;
+    std::string path;
+    int rank;
+};
+
+std::vector<std::string> split(const std::string &value, char delimiter) {
+    std::vector<std::string> parts;
+    std::stringstream ss(value);
+    std::string part;
+
+    while (std::getline(ss, part, delimiter))
+        if (part != "")
+            parts.push_back(part);
+
+    return parts;
+}
+
+std::string getSchemeName(const std::string &path) {
+    size_t start = path.find_last_of('/');
+    start = start == std::string::npos ? 0 : start + 1;
+
+    size_t end = path.find_last_of('.');
+    if (end == std::string::npos || end < start)
+        end = path.size();
+
+    return path.substr(start, end - start);
+}
+
+double getSeconds(Clock::time_point t1, Clock::time_point t2) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(t2 - t1).count() / 1e9;
+}
+
+// parser of the reducer with its command line defaults, options are set in the same way as options of a tuning profile
+ArgParser getReducerParser(const std::string &path, const ProfileOptions &options) {
+    ArgParser parser("ternary_addition_reducer");
+    addArguments(parser);
+
+    std::vector<std::string> args = {"ternary_addition_reducer", "-i", path};
+    std::vector<char *> argv;
+    for (auto &arg : args)
+        argv.push_back(&arg[0]);
+
+    parser.parse(argv.size(), argv.data());
+
+    for (const auto &option : options)
+        parser.set(option.first, option.second);
+
+    return parser;
+}
+
+template <typename T>
+T sample(const std::vector<T> &values, RandomGenerator &generator) {
+    std::uniform_int_distribution<int> distribution(0, values.size() - 1);
+    return values[distribution(generator)];
+}
+
+class Tuner {
+    std::vector<double> weights = {0, 0.1, 0.25, 0.5, 1};
+    std::vector<double> rates = {0, 0.1, 0.3, 0.5, 0.7};
+    std::vector<int> counts = {8, 16, 32, 64, 128, 256};
+    std::vector<int> maxNoImprovements = {1, 2, 3, 5, 8};
+    int seeds;
+    int seed;
+public:
+    Tuner(int seeds, int seed) : seeds(seeds), seed(seed) {
+    }
+
+    // the defaults of the reducer are the first config, so the recommendation is never worse than them on the measured runs
+    std::vector<TuneConfig> sampleConfigs(int count, RandomGenerator &generator) const {
+        ArgParser parser = getReducerParser("", {});
+        std::vector<TuneConfig> configs = {{
+            std::stod(parser.get("--ga-weight")), std::stod(parser.get("--gi-weight")), std::stod(parser.get("--part-initialization-rate")),
+            std::stoi(parser.get("--count")), std::stoi(parser.get("--max-no-improvements")), 0, 0
+        }};
+        std::set<std::tuple<double, double, double, int, int>> keys = {configs[0].getKey()};
+
+        for (int attempt = 0; attempt < count * 16 && (int) configs.size() < count; attempt++) {
+            TuneConfig config = {sample(weights, generator), sample(weights, generator), sample(rates, generator), sample(counts, generator), sample(maxNoImprovements, generator), 0, 0};
+
+            if (keys.insert(config.getKey()).second)
+                configs.push_back(config);
+        }
+
+        return configs;
+    }
+
+    // successive halving: all configs get a short budget, the best 1 / eta of them get eta times more, until one is left
+    TuneConfig race(std::vector<TuneConfig> configs, const std::vector<TuneScheme> &schemes, double budget, int eta) const {
+        for (int rung = 1; ; rung++) {
+            for (auto &config : configs)
+                evaluate(config, schemes, budget);
+
+            // equal additions are common on small schemes, then the config reaching them faster is better
+            std::stable_sort(configs.begin(), configs.end(), [](const TuneConfig &config1, const TuneConfig &config2) {
+                if (config1.score != config2.score)
+                    return config1.score < config2.score;
+
+                return config1.seconds < config2.seconds;
+            });
+
+            std::cout << "- rung " << rung << " (" << configs.size() << " configs, " << budget << " sec per run): best score " << configs[0].score << " in " << configs[0].seconds << " sec";
+            std::cout << ", worst score " << configs.back().score << " in " << configs.back().seconds << " sec" << std::endl;
+
+            if (configs.size() == 1)
+                return configs[0];
+
+            configs.resize((configs.size() + eta - 1) / eta);
+            budget *= eta;
+        }
+    }
+private:
+    // mean ratio of reduced to naive additions and mean time to reach it, every run has the same wall time on all threads,
+    // so the score compares additions per core-hour
+    void evaluate(TuneConfig &config, const std::vector<TuneScheme> &schemes, double budget) const {
+        config.score = 0;
+        config.seconds = 0;
+
+        for (const auto &scheme : schemes) {
+            for (int run = 0; run < seeds; run++) {
+                double seconds;
+                config.score += reduce(config, scheme, seed + run, budget, seconds);
+                config.seconds += seconds;
+            }
+        }
+
+        config.score /= schemes.size() * seeds;
+        config.seconds /= schemes.size() * seeds;
+    }
+
+    // the run restarts with the next seeds until the budget is spent, so stopping early by max no improvements does not save time,
+    // the reducer is set up from the command line defaults with the options of the config as the reducer does it with a tuning profile
+    double reduce(const TuneConfig &config, const TuneScheme &scheme, int runSeed, double budget, double &seconds) const {
+        ArgParser parser = getReducerParser(scheme.path, config.getOptions());
+        StrategyWeights strategyWeights = getStrategyWeights(parser);
+
+        int bestAdditions = INT_MAX;
+        int naiveAdditions = 1;
+        auto start = Clock::now();
+        seconds = 0;
+
+        for (int restart = 0; ; restart++) {
+            double offset = getSeconds(start, Clock::now());
+            double left = budget - offset;
+            if (left <= 0)
+                break;
+
+            std::ifstream f(scheme.path);
+            SchemeReducer reducer(config.count, "", strategyWeights, runSeed * 1000 + restart + 1);
+            std::streambuf *buffer = std::cout.rdbuf(nullptr);
+
+            reducer.setNuma(std::stoi(parser.get("--numa")) == 1, std::stoi(parser.get("--pin-threads")) == 1);
+            reducer.setSaving(false);
+            prepareReducer(parser, reducer);
+            reducer.initialize(f);
+            configureReducer(parser, reducer);
+            reducer.setMaxTime(left);
+            reducer.reduce(config.maxNoImprovements, 0, config.partialInitializationRate, 1);
+            std::cout.rdbuf(buffer);
+
+            if (reducer.getReducedAdditions() < bestAdditions) {
+                bestAdditions = reducer.getReducedAdditions();
+                seconds = offset + reducer.getImprovementTime();
+            }
+
+            naiveAdditions = reducer.getNaiveAdditions();
+        }
+
+        return double(bestAdditions) / naiveAdditions;
+    }
+};
+
+int main(int argc, char *argv[]) {
+    ArgParser parser("ternary_addition_reducer_tune", "Tune strategy weights and search parameters of the reducer on the reference schemes");
+
+    parser.add("--schemes", ArgType::String, "PATHS", "comma separated paths to reference schemes", "bench/schemes/2x2x2_m7.txt,bench/schemes/3x3x3_m23.txt,bench/schemes/4x4x4_m49.txt,bench/schemes/4x4x8_m98.txt");
+    parser.add("-o", ArgType::String, "PATH", "path to tuning profile, tuned classes are replaced and others are kept", "tuning_profile.txt");
+    parser.add("--configs", ArgType::Natural, "INT", "number of sampled configs per class", "16");
+    parser.add("--seeds", ArgType::Natural, "INT", "number of seeds per scheme and config", "3");
+    parser.add("--budget", ArgType::Real, "REAL", "seconds per run in the first rung", "2");
+    parser.add("--eta", ArgType::Natural, "INT", "reduction factor of configs and growth factor of the budget between rungs", "2");
+    parser.add("--seed", ArgType::Natural, "INT", "random seed", "42");
+
+    if (!parser.parse(argc, argv))
+        return 0;
+
+    std::vector<std::string> paths = split(parser.get("--schemes"), ',');
+    std::string outputPath = parser.get("-o");
+    int configsCount = std::stoi(parser.get("--configs"));
+    int seeds = std::stoi(parser.get("--seeds"));
+    double budget = std::stod(parser.get("--budget"));
+    int eta = std::stoi(parser.get("--eta"));
+    int seed = std::stoi(parser.get("--seed"));
+
+    if (configsCount == 0 || seeds == 0 || budget <= 0 || eta < 2) {
+        std::cout << "Configs, seeds and budget must be positive, eta must be at least 2" << std::endl;
+        return -1;
+    }
+
+    std::map<std::string, std::vector<TuneScheme>> classes;
+
+    for (const auto &path : paths) {
+        std::ifstream f(path);
+        int n1 = 0, n2 = 0, n3 = 0, rank = 0;
+
+        if (!(f >> n1 >> n2 >> n3 >> rank)) {
+            std::cout << "Unable to read scheme \"" << path << "\"" << std::endl;
+            return -1;
+        }
+
+        classes[TuningProfile::getClass(rank)].push_back({getSchemeName(path), path, rank});
+    }
+
+    TuningProfile profile;
+    profile.read(outputPath);
+
+    Tuner tuner(seeds, seed);
+    RandomGenerator generator(seed);
+
+    for (const auto &it : classes) {
+        std::cout << "Tune class " << it.first << " (";
+        for (size_t i = 0; i < it.second.size(); i++)
+            std::cout << (i ? ", " : "") << it.second[i].name;
+        std::cout << ") with " << omp_get_max_threads() << " threads:" << std::endl;
+
+        TuneConfig best = tuner.race(tuner.sampleConfigs(configsCount, generator), it.second, budget, eta);
+        std::stringstream comment;
+        comment << "score " << best.score << " (reduced / naive additions), " << omp_get_max_threads() << " threads";
+
+        std::cout << "- recommended:";
+        for (const auto &option : best.getOptions())
+            std::cout << " " << option.first << " " << option.second;
+        std::cout << std::endl << std::endl;
+
+        profile.set(it.first, best.getOptions(), comment.str());
+    }
+
+    if (!profile.write(outputPath)) {
+        std::cout << "Unable to write tuning profile \"" << outputPath << "\"" << std::endl;
+        return -1;
+    }
+
+    std::cout << "Tuning profile saved to \"" << outputPath << "\"" << std::endl;
+    return 0;
+}
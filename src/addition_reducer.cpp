@@ -6,29 +6,31 @@ StrategyWeights::StrategyWeights() : uniformDistribution(0.0, 1.0) {
     weightedRandom = 1;
     greedyIntersections = 8;
     greedyPotential = 0;
+    beamSearch = 0;
     mix = 0;
+    beamWidth = 4;
 }
 
 double StrategyWeights::getTotal() const {
-    return greedyIntersections + greedyAlternative + greedyRandom + weightedRandom + greedyPotential + mix;
+    return greedyIntersections + greedyAlternative + greedyRandom + weightedRandom + greedyPotential + beamSearch + mix;
 }
 
-Strategy StrategyWeights::select(std::mt19937 &generator) {
+Strategy StrategyWeights::select(RandomGenerator &generator) {
     Strategy strategies[] = {
         Strategy::GreedyAlternative, Strategy::GreedyRandom, Strategy::WeightedRandom,
-        Strategy::GreedyIntersections, Strategy::GreedyPotential, Strategy::Mix
+        Strategy::GreedyIntersections, Strategy::GreedyPotential, Strategy::BeamSearch, Strategy::Mix
     };
 
     double weights[] = {
         greedyAlternative, greedyRandom, weightedRandom,
-        greedyIntersections, greedyPotential, mix
+        greedyIntersections, greedyPotential, beamSearch, mix
     };
 
     double p = uniformDistribution(generator) * getTotal();
     double sum = 0;
     int last = 0;
 
-    for (int i = 0; i < 6; i++) {
+    for (int i = 0; i < 7; i++) {
         if (weights[i] == 0)
             continue;
 
@@ -43,13 +45,21 @@ Strategy StrategyWeights::select(std::mt19937 &generator) {
 }
 
 
-AdditionReducer::AdditionReducer() : uniformDistribution(0.0, 1.0), boolDistribution(0, 1) {
+AdditionReducer::AdditionReducer() : uniformDistribution(0.0, 1.0) {
     realVariables = 0;
     naiveAdditions = 0;
+    additions = 0;
     maxCount = 0;
     strategy = Strategy::Greedy;
     scale = 0;
     alpha = 0;
+    beamWidth = 4;
+    tasks = 1;
+    crossed = false;
+    forked = false;
+    maskWords = 0;
+    rowStorage = RowStorage::Dense;
+    sparse = false;
 }
 
 bool AdditionReducer::addExpression(const std::vector<int> &expression) {
@@ -69,18 +79,71 @@ bool AdditionReducer::addExpression(const std::vector<int> &expression) {
     }
 
     expressions.push_back(parsed);
+    references.push_back(0);
     naiveAdditions += parsed.size() - 1;
+    additions += parsed.size() - 1;
 
     if (variables > realVariables)
         realVariables = variables;
 
+    updateIndex();
     return true;
 }
 
+int AdditionReducer::collapseDuplicates() {
+    std::map<std::vector<int>, std::pair<int, int>> rows;
+    int duplicates = 0;
+
+    for (size_t index = 0; index < expressions.size(); index++) {
+        std::vector<int> row(expressions[index].begin(), expressions[index].end());
+        std::sort(row.begin(), row.end(), [](int variable1, int variable2) {
+            return abs(variable1) < abs(variable2);
+        });
+
+        // rows are compared up to sign: the first variable of the key is positive
+        int sign = !row.empty() && row[0] < 0 ? -1 : 1;
+        for (int &variable : row)
+            variable *= sign;
+
+        if (row.size() < 2)
+            continue;
+
+        auto it = rows.find(row);
+        if (it == rows.end()) {
+            rows[row] = {index, sign};
+            continue;
+        }
+
+        references.modify(index) = sign * it->second.second * (it->second.first + 1);
+        duplicates++;
+    }
+
+    return duplicates;
+}
+
 void AdditionReducer::setStrategy(Strategy strategy) {
     this->strategy = strategy;
     this->scale = 0;
     this->alpha = 0;
+    this->crossed = false;
+    this->forked = false;
+}
+
+void AdditionReducer::setStrategyWeights(const StrategyWeights &strategyWeights) {
+    this->strategyWeights = strategyWeights;
+}
+
+void AdditionReducer::setBeamWidth(int beamWidth) {
+    this->beamWidth = std::max(beamWidth, 1);
+}
+
+void AdditionReducer::setTasks(int tasks) {
+    this->tasks = std::max(tasks, 1);
+}
+
+void AdditionReducer::setRowStorage(RowStorage rowStorage) {
+    this->rowStorage = rowStorage;
+    updateIndex();
 }
 
 void AdditionReducer::partialInitialize(const AdditionReducer &reducer, size_t count) {
@@ -88,38 +151,356 @@ void AdditionReducer::partialInitialize(const AdditionReducer &reducer, size_t c
         replaceSubexpression(reducer.freshVariables[index]);
 }
 
+bool AdditionReducer::applyFreshVariables(const std::vector<std::pair<int, int>> &freshVariables) {
+    for (const auto &subexpression : freshVariables) {
+        int maxIndex = realVariables + this->freshVariables.size();
+        int i = abs(subexpression.first);
+        int j = abs(subexpression.second);
+
+        if (i == 0 || j == 0 || i == j || i > maxIndex || j > maxIndex)
+            return false;
+
+        replaceSubexpression(subexpression);
+    }
+
+    return true;
+}
+
+bool AdditionReducer::isPermutation(const AdditionReducer &reducer, const std::vector<int> &permutation) const {
+    if (realVariables != reducer.realVariables || expressions.size() != reducer.expressions.size() || (int) permutation.size() <= realVariables)
+        return false;
+
+    // rows are compared as multisets up to sign, the order of rows does not change the cost
+    auto getRows = [](const SharedRows<std::unordered_set<int>> &expressions, const std::vector<int> &permutation) {
+        std::vector<std::vector<int>> rows;
+
+        for (const auto &expression : expressions) {
+            std::vector<int> row;
+
+            for (int variable : expression)
+                row.push_back(variable > 0 ? permutation[variable] : -permutation[-variable]);
+
+            std::sort(row.begin(), row.end(), [](int variable1, int variable2) {
+                return abs(variable1) < abs(variable2);
+            });
+
+            if (!row.empty() && row[0] < 0)
+                for (int &variable : row)
+                    variable = -variable;
+
+            rows.push_back(row);
+        }
+
+        std::sort(rows.begin(), rows.end());
+        return rows;
+    };
+
+    std::vector<int> identity(permutation.size());
+    std::iota(identity.begin(), identity.end(), 0);
+
+    return getRows(reducer.expressions, permutation) == getRows(expressions, identity);
+}
+
+bool AdditionReducer::applyPermutation(const AdditionReducer &reducer, const std::vector<int> &permutation) {
+    if ((int) permutation.size() <= realVariables)
+        return false;
+
+    for (size_t index = freshVariables.size(); index < reducer.freshVariables.size(); index++) {
+        int i = reducer.freshVariables[index].first;
+        int j = reducer.freshVariables[index].second;
+
+        // fresh variables keep their indices, real variables are permuted
+        if (abs(i) <= realVariables)
+            i = i > 0 ? permutation[i] : -permutation[-i];
+
+        if (abs(j) <= realVariables)
+            j = j > 0 ? permutation[j] : -permutation[-j];
+
+        canonizeSubexpression(i, j);
+        replaceSubexpression({i, j});
+    }
+
+    return true;
+}
+
+void AdditionReducer::crossover(const PackedSequence &parent1, size_t count1, const PackedSequence &parent2) {
+    size_t start = freshVariables.size();
+
+    for (size_t index = start; index < count1 && index < parent1.size(); index++)
+        replaceSubexpression(parent1[index]);
+
+    // variables of the second parent are taken while their operands exist in the child and they are still profitable
+    std::unordered_map<std::pair<int, int>, int, PairHash> variables;
+    for (size_t index = start; index < freshVariables.size(); index++)
+        variables[freshVariables[index]] = realVariables + index + 1;
+
+    int shared = realVariables + start;
+    int real = realVariables;
+    std::vector<int> mapped(parent2.size(), 0);
+
+    auto remap = [shared, real, &mapped](int variable) {
+        int index = abs(variable);
+        if (index > shared)
+            index = mapped[index - real - 1];
+
+        return variable > 0 ? index : -index;
+    };
+
+    for (size_t index = start; index < parent2.size(); index++) {
+        int i = remap(parent2[index].first);
+        int j = remap(parent2[index].second);
+
+        if (i == 0 || j == 0)
+            continue;
+
+        canonizeSubexpression(i, j);
+
+        auto it = variables.find({i, j});
+        if (it != variables.end()) {
+            mapped[index] = it->second;
+        }
+        else if (countSubexpression({i, j}) > 1) {
+            replaceSubexpression({i, j});
+            mapped[index] = realVariables + freshVariables.size();
+            variables[{i, j}] = mapped[index];
+        }
+    }
+
+    crossed = true;
+}
+
+void AdditionReducer::fork(const AdditionReducer &trunk) {
+    copyFrom(trunk);
+    forked = true;
+}
+
 void AdditionReducer::copyFrom(const AdditionReducer &reducer) {
     realVariables = reducer.realVariables;
     naiveAdditions = reducer.naiveAdditions;
+    additions = reducer.additions;
     maxCount = reducer.maxCount;
 
-    freshVariables = std::vector<std::pair<int, int>>(reducer.freshVariables);
-    expressions.clear();
+    // rows and indexes are shared with the copied reducer until they are modified, so the copy cost does not depend on the scheme size
+    freshVariables = reducer.freshVariables;
+    expressions = reducer.expressions;
+    references = reducer.references;
+    maskWords = reducer.maskWords;
+    masks = reducer.masks;
+    rowStorage = reducer.rowStorage;
+    sparse = reducer.sparse;
+    sortedRows = reducer.sortedRows;
+    postings = reducer.postings;
+
+    // pair counts start from an empty table, so the order of equal counts does not depend on the previous use of this reducer
+    subexpressions = std::unordered_map<std::pair<int, int>, int, PairHash>();
+}
+
+// copies all rows and indexes, so the reducer does not share memory with the copied one
+void AdditionReducer::unshare() {
+    freshVariables.unshare();
+    expressions.unshare();
+    references.unshare();
+    masks.unshare();
+    sortedRows.unshare();
+    postings.unshare();
+}
+
+void AdditionReducer::reduce(RandomGenerator &generator) {
+    scale = uniformDistribution(generator) * 0.5;
+    alpha = 0.5 + uniformDistribution(generator) * 0.5;
+
+    if (strategy == Strategy::BeamSearch) {
+        reduceBeamSearch(generator);
+    }
+    else {
+        while (updateSubexpressions()) {
+            std::pair<int, int> subexpression = selectSubexpression(generator);
+            replaceSubexpression(subexpression);
+        }
+    }
 
-    for (size_t i = 0; i < reducer.expressions.size(); i++)
-        expressions.push_back(std::unordered_set<int>(reducer.expressions[i]));
+    foldDuplicates();
 }
 
-void AdditionReducer::reduce(std::mt19937 &generator) {
+void AdditionReducer::reduceTrunk(RandomGenerator &generator, int steps) {
     scale = uniformDistribution(generator) * 0.5;
     alpha = 0.5 + uniformDistribution(generator) * 0.5;
 
-    while (updateSubexpressions()) {
+    // choices before the first tie of the most frequent pairs are nearly the same for all strategies, forks diverge from there
+    for (int step = 0; updateSubexpressions(); step++) {
+        if (step >= steps && getTopTies() > 1)
+            break;
+
         std::pair<int, int> subexpression = selectSubexpression(generator);
         replaceSubexpression(subexpression);
     }
 }
 
+void AdditionReducer::localSearch(RandomGenerator &generator, int steps, size_t fixed) {
+    double temperature = uniformDistribution(generator) * 2;
+    scale = temperature / 2;
+
+    AdditionReducer current;
+    AdditionReducer candidate;
+    AdditionReducer best;
+
+    current.copyFrom(*this);
+    best.copyFrom(*this);
+    candidate.setStrategy(Strategy::Mix);
+    candidate.setStrategyWeights(strategyWeights);
+    candidate.setTasks(tasks);
+
+    std::uniform_int_distribution<int> removeDistribution(1, 3);
+    std::vector<int> expanded;
+
+    for (int step = 0; step < steps && current.freshVariables.size() > fixed; step++) {
+        std::uniform_int_distribution<int> indexDistribution(fixed, current.freshVariables.size() - 1);
+        std::vector<bool> removed(current.freshVariables.size(), false);
+
+        for (int count = removeDistribution(generator); count > 0; count--)
+            removed[indexDistribution(generator)] = true;
+
+        // destroy: expand some fresh variables back into expressions, repair: reduce again
+        candidate.copyFrom(current);
+        candidate.removeFreshVariables(removed, expanded);
+        candidate.repair(generator, expanded);
+
+        int delta = candidate.getAdditions() - current.getAdditions();
+        double currentTemperature = temperature * (1 - double(step) / steps);
+
+        if (delta <= 0 || (currentTemperature > 0 && uniformDistribution(generator) < exp(-delta / currentTemperature)))
+            current.copyFrom(candidate);
+
+        if (current.getAdditions() < best.getAdditions() || (current.getAdditions() == best.getAdditions() && current.getFreshVars() < best.getFreshVars()))
+            best.copyFrom(current);
+    }
+
+    freshVariables = best.freshVariables;
+    expressions = best.expressions;
+    masks = best.masks;
+    sortedRows = best.sortedRows;
+    postings = best.postings;
+    additions = best.additions;
+}
+
+void AdditionReducer::removeFreshVariables(std::vector<bool> removed, std::vector<int> &expanded) {
+    int freshCount = freshVariables.size();
+    int first = freshCount;
+
+    // variables depending on removed ones are removed too
+    for (int k = 0; k < freshCount; k++) {
+        int i = abs(freshVariables[k].first) - realVariables - 1;
+        int j = abs(freshVariables[k].second) - realVariables - 1;
+
+        if ((i >= 0 && removed[i]) || (j >= 0 && removed[j]))
+            removed[k] = true;
+
+        if (removed[k] && first == freshCount)
+            first = k;
+    }
+
+    // only rows found in the postings of removed and renumbered variables are modified
+    std::vector<int> rows;
+
+    // operands always have smaller indices, so expanding from the last variable leaves no removed ones
+    for (int k = freshCount - 1; k >= first; k--) {
+        if (!removed[k])
+            continue;
+
+        int varIndex = realVariables + k + 1;
+
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            std::vector<int> posting = postings[getPostingIndex(varIndex * sign)];
+
+            for (int row : posting) {
+                auto &expression = expressions.modify(row);
+                expression.erase(varIndex * sign);
+                erasePosting(varIndex * sign, row);
+                additions--;
+
+                for (int variable : {freshVariables[k].first * sign, freshVariables[k].second * sign}) {
+                    if (!expression.insert(variable).second)
+                        continue;
+
+                    postings.modify(getPostingIndex(variable)).push_back(row);
+                    additions++;
+                }
+
+                rows.push_back(row);
+            }
+        }
+
+        additions--;
+    }
+
+    expanded = rows;
+    std::sort(expanded.begin(), expanded.end());
+    expanded.erase(std::unique(expanded.begin(), expanded.end()), expanded.end());
+
+    std::vector<int> indices(realVariables + freshCount + 1);
+    for (int i = 0; i <= realVariables; i++)
+        indices[i] = i;
+
+    auto remap = [&indices](int variable) {
+        return variable > 0 ? indices[variable] : -indices[-variable];
+    };
+
+    std::vector<std::pair<int, int>> kept(freshVariables.begin(), freshVariables.begin() + first);
+
+    for (int k = 0; k < first; k++)
+        indices[realVariables + k + 1] = realVariables + k + 1;
+
+    // kept variables move down in increasing order, so the postings of their new indices are already empty
+    for (int k = first; k < freshCount; k++) {
+        if (removed[k])
+            continue;
+
+        int varIndex = realVariables + k + 1;
+        int newIndex = realVariables + kept.size() + 1;
+
+        indices[varIndex] = newIndex;
+        kept.push_back({remap(freshVariables[k].first), remap(freshVariables[k].second)});
+
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            for (int row : postings[getPostingIndex(varIndex * sign)]) {
+                auto &expression = expressions.modify(row);
+                expression.erase(varIndex * sign);
+                expression.insert(newIndex * sign);
+                rows.push_back(row);
+            }
+
+            postings.swap(getPostingIndex(varIndex * sign), getPostingIndex(newIndex * sign));
+        }
+    }
+
+    freshVariables = kept;
+    postings.resize(getPostingIndex(-realVariables - (int) kept.size()) + 1);
+
+    std::sort(rows.begin(), rows.end());
+    rows.erase(std::unique(rows.begin(), rows.end()), rows.end());
+    updateRows(rows);
+}
+
+// reduces a solution again after removeFreshVariables: pair counts are updated only for the rows of every replacement
+void AdditionReducer::repair(RandomGenerator &generator, const std::vector<int> &expanded) {
+    scale = uniformDistribution(generator) * 0.5;
+    alpha = 0.5 + uniformDistribution(generator) * 0.5;
+
+    countExpandedSubexpressions(expanded);
+
+    while (updateMaxCount()) {
+        std::pair<int, int> subexpression = selectSubexpression(generator);
+        replaceCountedSubexpression(subexpression);
+    }
+
+    foldDuplicates();
+}
+
 int AdditionReducer::getNaiveAdditions() const {
     return naiveAdditions;
 }
 
 int AdditionReducer::getAdditions() const {
-    int additions = freshVariables.size();
-
-    for (size_t i = 0; i < expressions.size(); i++)
-        additions += expressions[i].size() - 1;
-
     return additions;
 }
 
@@ -127,7 +508,91 @@ int AdditionReducer::getFreshVars() const {
     return freshVariables.size();
 }
 
+MemoryCost AdditionReducer::getMemoryCost() const {
+    int size = freshVariables.size();
+    int unused = expressions.size();
+    std::vector<int> firstUse(size, unused);
+    std::vector<int> lastUse(size, -1);
+    MemoryCost cost = {0, 0};
+
+    for (int i = 0; i < (int) expressions.size(); i++) {
+        if (expressions[i].size() > 1)
+            cost.traffic += expressions[i].size() + 1;
+
+        for (int variable : expressions[i]) {
+            int index = abs(variable) - realVariables - 1;
+
+            if (index >= 0) {
+                firstUse[index] = std::min(firstUse[index], i);
+                lastUse[index] = std::max(lastUse[index], i);
+            }
+        }
+    }
+
+    // operands are needed from the first use of every dependent variable, dependents always have greater indices
+    for (int index = size - 1; index >= 0; index--) {
+        if (lastUse[index] < 0)
+            continue;
+
+        cost.traffic += 3;
+
+        for (int variable : {freshVariables[index].first, freshVariables[index].second}) {
+            int operand = abs(variable) - realVariables - 1;
+
+            if (operand >= 0) {
+                firstUse[operand] = std::min(firstUse[operand], firstUse[index]);
+                lastUse[operand] = std::max(lastUse[operand], firstUse[index]);
+            }
+        }
+    }
+
+    std::vector<int> delta(expressions.size() + 1, 0);
+    for (int index = 0; index < size; index++) {
+        if (lastUse[index] < 0)
+            continue;
+
+        delta[firstUse[index]]++;
+        delta[lastUse[index] + 1]--;
+    }
+
+    int live = 0;
+    for (int i = 0; i < (int) expressions.size(); i++) {
+        live += delta[i];
+        cost.live = std::max(cost.live, live);
+    }
+
+    return cost;
+}
+
+int AdditionReducer::getMaxVariable() const {
+    return realVariables + naiveAdditions;
+}
+
+int AdditionReducer::getRealVariables() const {
+    return realVariables;
+}
+
+bool AdditionReducer::isSparse() const {
+    return sparse;
+}
+
+const std::vector<std::pair<int, int>>& AdditionReducer::getFreshVariables() const {
+    return freshVariables.get();
+}
+
+const SharedRows<std::unordered_set<int>>& AdditionReducer::getExpressions() const {
+    return expressions;
+}
+
 std::string AdditionReducer::getStrategy() const {
+    std::string name = getStrategyName();
+    if (crossed)
+        return "x" + name;
+
+    return forked ? "f" + name : name;
+}
+
+std::string AdditionReducer::getStrategyName() const {
     if (strategy == Strategy::Greedy)
         return "g";
 
@@ -141,12 +606,19 @@ std::string AdditionReducer::getStrategy() const {
         return "mix";
 
     std::stringstream ss;
+    if (strategy == Strategy::BeamSearch) {
+        ss << "bs (" << beamWidth << ")";
+        return ss.str();
+    }
+
     if (strategy == Strategy::GreedyRandom)
         ss << "gr (" << int(scale * 100) << ")";
     else if (strategy == Strategy::GreedyIntersections)
         ss << "gi (" << int(scale * 100) << ")";
     else if (strategy == Strategy::GreedyPotential)
         ss << "gp (" << int(scale * 100) << ")";
+    else if (strategy == Strategy::LocalSearch)
+        ss << "ls (" << int(scale * 100) << ")";
 
     return ss.str();
 }
@@ -199,20 +671,31 @@ void AdditionReducer::write(std::ostream &os, const std::string &name, const std
 bool AdditionReducer::updateSubexpressions() {
     subexpressions.clear();
 
-    for (const auto& expression: expressions) {
-        for (auto it1 = expression.begin(); it1 != expression.end(); it1++) {
-            for (auto it2 = std::next(it1); it2 != expression.end(); it2++) {
-                int i = *it1;
-                int j = *it2;
-                canonizeSubexpression(i, j);
+    if (tasks > 1 && expressions.size() >= (size_t) tasks * 2) {
+        std::vector<std::unordered_map<std::pair<int, int>, int, PairHash>> counts(tasks);
+        size_t size = sparse ? realVariables + freshVariables.size() : expressions.size();
 
-                auto result = subexpressions.find({i, j});
-                if (result == subexpressions.end())
-                    subexpressions[{i, j}] = 1;
-                else
-                    result->second++;
-            }
+        // expression ranges (first variable ranges for sparse rows) are counted by tasks into own maps (locals are firstprivate in tasks by default),
+        // idle threads of the enclosing team take them
+        #pragma omp taskloop grainsize(1) shared(counts)
+        for (int task = 0; task < tasks; task++) {
+            if (sparse)
+                countSparseSubexpressions(size * task / tasks + 1, size * (task + 1) / tasks + 1, counts[task]);
+            else
+                countSubexpressions(size * task / tasks, size * (task + 1) / tasks, counts[task]);
         }
+
+        subexpressions = std::move(counts[0]);
+
+        for (int task = 1; task < tasks; task++)
+            for (const auto &pair : counts[task])
+                subexpressions[pair.first] += pair.second;
+    }
+    else if (sparse) {
+        countSparseSubexpressions(1, realVariables + freshVariables.size() + 1, subexpressions);
+    }
+    else {
+        countSubexpressions(0, expressions.size(), subexpressions);
     }
 
     maxCount = 0;
@@ -228,6 +711,212 @@ bool AdditionReducer::updateSubexpressions() {
     return maxCount > 0;
 }
 
+// no pair of a reduced solution repeats, so after expanding fresh variables only pairs of the expanded rows are counted over all rows
+void AdditionReducer::countExpandedSubexpressions(const std::vector<int> &expanded) {
+    std::unordered_set<std::pair<int, int>, PairHash> counted;
+    subexpressions.clear();
+
+    for (int row : expanded) {
+        if (references[row])
+            continue;
+
+        const auto &expression = expressions[row];
+
+        for (auto it1 = expression.begin(); it1 != expression.end(); it1++) {
+            for (auto it2 = std::next(it1); it2 != expression.end(); it2++) {
+                int i = *it1;
+                int j = *it2;
+                canonizeSubexpression(i, j);
+
+                if (!counted.insert({i, j}).second)
+                    continue;
+
+                int count = countSubexpression({i, j});
+                if (count > 1)
+                    subexpressions[{i, j}] = count;
+            }
+        }
+    }
+}
+
+// pairs with the replaced variables are decremented and pairs with the fresh variable are counted in the replaced rows,
+// counts of other pairs do not change
+void AdditionReducer::replaceCountedSubexpression(const std::pair<int, int> &subexpression) {
+    int varIndex = realVariables + freshVariables.size() + 1;
+    int i = subexpression.first;
+    int j = subexpression.second;
+    std::vector<int> rows;
+
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        size_t begin = rows.size();
+        findRows(i * sign, j * sign, rows);
+
+        for (size_t index = begin; index < rows.size(); index++) {
+            if (references[rows[index]])
+                continue;
+
+            decrementSubexpression(i * sign, j * sign);
+
+            for (int variable : expressions[rows[index]]) {
+                if (variable == i * sign || variable == j * sign)
+                    continue;
+
+                decrementSubexpression(i * sign, variable);
+                decrementSubexpression(j * sign, variable);
+            }
+        }
+    }
+
+    replaceSubexpression(subexpression);
+
+    std::unordered_map<std::pair<int, int>, int, PairHash> counts;
+
+    for (int row : rows) {
+        if (references[row])
+            continue;
+
+        int variable = expressions[row].count(varIndex) ? varIndex : -varIndex;
+
+        for (int other : expressions[row]) {
+            if (other == variable)
+                continue;
+
+            int first = variable;
+            int second = other;
+            canonizeSubexpression(first, second);
+            counts[{first, second}]++;
+        }
+    }
+
+    for (const auto &pair : counts)
+        if (pair.second > 1)
+            subexpressions[pair.first] = pair.second;
+}
+
+// only pairs repeated in several rows are kept, so a pair missing in the table is not counted anymore
+void AdditionReducer::decrementSubexpression(int i, int j) {
+    canonizeSubexpression(i, j);
+    auto it = subexpressions.find({i, j});
+
+    if (it != subexpressions.end() && --it->second < 2)
+        subexpressions.erase(it);
+}
+
+bool AdditionReducer::updateMaxCount() {
+    maxCount = 0;
+
+    for (const auto &pair : subexpressions)
+        maxCount = std::max(maxCount, pair.second);
+
+    return maxCount > 0;
+}
+
+int AdditionReducer::getTopTies() const {
+    int ties = 0;
+
+    for (const auto &pair : subexpressions)
+        ties += pair.second == maxCount;
+
+    return ties;
+}
+
+void AdditionReducer::countSubexpressions(size_t begin, size_t end, std::unordered_map<std::pair<int, int>, int, PairHash> &counts) const {
+    for (size_t index = begin; index < end; index++) {
+        if (references[index])
+            continue;
+
+        const auto &expression = expressions[index];
+
+        for (auto it1 = expression.begin(); it1 != expression.end(); it1++) {
+            for (auto it2 = std::next(it1); it2 != expression.end(); it2++) {
+                int i = *it1;
+                int j = *it2;
+                canonizeSubexpression(i, j);
+
+                auto result = counts.find({i, j});
+                if (result == counts.end())
+                    counts[{i, j}] = 1;
+                else
+                    result->second++;
+            }
+        }
+    }
+}
+
+// pairs with the first variable in [begin, end) are counted in dense counters of the second variable: rows containing the first variable
+// (or its negation) are merged from the position after it in sorted order, so only pairs of several rows reach the hash table
+void AdditionReducer::countSparseSubexpressions(int begin, int end, std::unordered_map<std::pair<int, int>, int, PairHash> &counts) const {
+    std::vector<int> counters(postings.size(), 0);
+    std::vector<int> touched;
+
+    for (int variable = begin; variable < end; variable++) {
+        for (int sign = 1; sign >= -1; sign -= 2) {
+            for (int row : postings[getPostingIndex(variable * sign)]) {
+                if (references[row])
+                    continue;
+
+                const std::vector<int> &sorted = sortedRows[row];
+                auto it = std::upper_bound(sorted.begin(), sorted.end(), variable, [](int value, int other) {
+                    return value < abs(other);
+                });
+
+                for (; it != sorted.end(); it++) {
+                    int index = getPostingIndex(*it * sign);
+
+                    if (counters[index]++ == 0)
+                        touched.push_back(index);
+                }
+            }
+        }
+
+        for (int index : touched) {
+            if (counters[index] > 1)
+                counts[{variable, index % 2 ? -index / 2 : index / 2}] = counters[index];
+
+            counters[index] = 0;
+        }
+
+        touched.clear();
+    }
+}
+
+void AdditionReducer::foldDuplicates() {
+    for (size_t index = 0; index < expressions.size(); index++) {
+        int reference = abs(references[index]) - 1;
+
+        if (reference < 0 || expressions[reference].size() < 2)
+            continue;
+
+        std::vector<int> row(expressions[reference].begin(), expressions[reference].end());
+        std::sort(row.begin(), row.end(), [](int variable1, int variable2) {
+            return abs(variable1) < abs(variable2);
+        });
+
+        // the referenced row becomes one variable, replacements change its duplicates in the same way
+        int variable = row[0];
+
+        for (size_t k = 1; k < row.size(); k++) {
+            int i = variable;
+            int j = row[k];
+            canonizeSubexpression(i, j);
+            replaceSubexpression({i, j});
+
+            int freshVariable = realVariables + freshVariables.size();
+            variable = (i == -variable || i == -row[k]) ? -freshVariable : freshVariable;
+        }
+    }
+}
+
+int AdditionReducer::getDuplicateAdditions() const {
+    int additions = 0;
+
+    for (size_t index = 0; index < expressions.size(); index++)
+        if (references[index])
+            additions += expressions[index].size() - 1;
+
+    return additions;
+}
+
 void AdditionReducer::canonizeSubexpression(int &i, int &j) const {
     if (abs(i) > abs(j))
         std::swap(i, j);
@@ -238,7 +927,7 @@ void AdditionReducer::canonizeSubexpression(int &i, int &j) const {
     }
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpression(std::mt19937 &generator) {
+std::pair<int, int> AdditionReducer::selectSubexpression(RandomGenerator &generator) {
     Strategy strategy = getStepStrategy(generator);
 
     if (strategy == Strategy::GreedyAlternative)
@@ -268,7 +957,7 @@ std::pair<int, int> AdditionReducer::selectSubexpressionGreedy() {
     return it->first;
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpressionGreedyAlternative(std::mt19937 &generator) {
+std::pair<int, int> AdditionReducer::selectSubexpressionGreedyAlternative(RandomGenerator &generator) {
     std::vector<std::pair<int, int>> top;
 
     for (const auto& pair: subexpressions)
@@ -279,25 +968,86 @@ std::pair<int, int> AdditionReducer::selectSubexpressionGreedyAlternative(std::m
     return top[dist(generator)];
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpressionGreedyRandom(std::mt19937 &generator) {
+std::pair<int, int> AdditionReducer::selectSubexpressionGreedyRandom(RandomGenerator &generator) {
     if (uniformDistribution(generator) < scale)
         return selectSubexpressionGreedyAlternative(generator);
 
     return selectSubexpressionWeightedRandom(generator);
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpressionGreedyIntersections(std::mt19937 &generator) {
+std::pair<int, int> AdditionReducer::selectSubexpressionGreedyIntersections(RandomGenerator &generator) {
+    std::vector<std::pair<std::pair<int, int>, int>> candidates(subexpressions.begin(), subexpressions.end());
     double maxScore = 0;
     std::pair<int, int> best = {0, 0};
 
-    for (const auto& pair1: subexpressions) {
+    if (tasks == 1 || candidates.size() < (size_t) tasks * 2) {
+        scoreIntersections(candidates, 0, candidates.size(), generator, maxScore, best);
+        return best;
+    }
+
+    // every candidate range gets its own generator, so the choice does not depend on the threads executing tasks
+    std::vector<uint64_t> seeds(tasks);
+    for (int task = 0; task < tasks; task++)
+        seeds[task] = generator();
+
+    std::vector<double> maxScores(tasks, 0);
+    std::vector<std::pair<int, int>> bests(tasks, {0, 0});
+    size_t size = candidates.size();
+
+    #pragma omp taskloop grainsize(1) shared(candidates, seeds, maxScores, bests)
+    for (int task = 0; task < tasks; task++) {
+        RandomGenerator taskGenerator(seeds[task]);
+        scoreIntersections(candidates, size * task / tasks, size * (task + 1) / tasks, taskGenerator, maxScores[task], bests[task]);
+    }
+
+    for (int task = 0; task < tasks; task++) {
+        if (maxScores[task] > maxScore) {
+            maxScore = maxScores[task];
+            best = bests[task];
+        }
+    }
+
+    return best;
+}
+
+std::pair<int, int> AdditionReducer::selectSubexpressionGreedyPotential(RandomGenerator &generator) {
+    std::vector<std::pair<std::pair<int, int>, int>> candidates(subexpressions.begin(), subexpressions.end());
+    double maxScore = 0;
+    std::pair<int, int> best = {0, 0};
+
+    if (tasks == 1 || candidates.size() < (size_t) tasks * 2) {
+        scorePotentials(candidates, 0, candidates.size(), maxScore, best);
+        return best;
+    }
+
+    std::vector<double> maxScores(tasks, 0);
+    std::vector<std::pair<int, int>> bests(tasks, {0, 0});
+    size_t size = candidates.size();
+
+    #pragma omp taskloop grainsize(1) shared(candidates, maxScores, bests)
+    for (int task = 0; task < tasks; task++)
+        scorePotentials(candidates, size * task / tasks, size * (task + 1) / tasks, maxScores[task], bests[task]);
+
+    for (int task = 0; task < tasks; task++) {
+        if (maxScores[task] > maxScore) {
+            maxScore = maxScores[task];
+            best = bests[task];
+        }
+    }
+
+    return best;
+}
+
+void AdditionReducer::scoreIntersections(const std::vector<std::pair<std::pair<int, int>, int>> &candidates, size_t begin, size_t end, RandomGenerator &generator, double &maxScore, std::pair<int, int> &best) const {
+    for (size_t index = begin; index < end; index++) {
+        const auto &pair1 = candidates[index];
         double intScore = 0;
 
-        for (const auto &pair2: subexpressions) {
+        for (const auto &pair2: candidates) {
             if (pair1 == pair2)
                 continue;
 
-            if (isIntersects(pair1.first, pair2.first) ^ boolDistribution(generator))
+            if (isIntersects(pair1.first, pair2.first) ^ generator.bit())
                 intScore += alpha * (pair2.second - 1);
             else
                 intScore += (1 - alpha) * (pair2.second - 1);
@@ -310,16 +1060,14 @@ std::pair<int, int> AdditionReducer::selectSubexpressionGreedyIntersections(std:
             best = pair1.first;
         }
     }
-
-    return best;
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpressionGreedyPotential(std::mt19937 &generator) {
-    double maxScore = 0;
-    std::pair<int, int> best = {0, 0};
+void AdditionReducer::scorePotentials(const std::vector<std::pair<std::pair<int, int>, int>> &candidates, size_t begin, size_t end, double &maxScore, std::pair<int, int> &best) const {
     int varIndex = realVariables + freshVariables.size() + 1;
+    std::vector<int> replaced;
 
-    for (const auto &pair: subexpressions) {
+    for (size_t index = begin; index < end; index++) {
+        const auto &pair = candidates[index];
         std::pair<int, int> subexpression = pair.first;
         int i = subexpression.first;
         int j = subexpression.second;
@@ -327,38 +1075,38 @@ std::pair<int, int> AdditionReducer::selectSubexpressionGreedyPotential(std::mt1
         std::unordered_set<std::pair<int, int>, PairHash> potentialSubexpressions;
         int potential = 0;
 
-        for (auto& expression: expressions) {
+        for (size_t row = 0; row < expressions.size(); row++) {
+            if (references[row])
+                continue;
+
+            // the row after the replacement is built aside, shared rows are never modified by scoring
+            const auto &expression = expressions[row];
             const auto end = expression.end();
             int sign = 0;
 
-            if (expression.find(i) != end && expression.find(j) != end) {
-                expression.erase(i);
-                expression.erase(j);
-                expression.insert(varIndex);
+            if (expression.find(i) != end && expression.find(j) != end)
                 sign = 1;
-            }
-            else if (expression.find(-i) != end && expression.find(-j) != end) {
-                expression.erase(-i);
-                expression.erase(-j);
-                expression.insert(-varIndex);
+            else if (expression.find(-i) != end && expression.find(-j) != end)
                 sign = -1;
-            }
 
-            for (auto it1 = expression.begin(); it1 != expression.end(); it1++) {
-                for (auto it2 = std::next(it1); it2 != expression.end(); it2++) {
-                    int si = *it1;
-                    int sj = *it2;
+            replaced.clear();
+
+            for (int variable : expression)
+                if (!sign || (variable != i * sign && variable != j * sign))
+                    replaced.push_back(variable);
+
+            if (sign)
+                replaced.push_back(varIndex * sign);
+
+            for (size_t k1 = 0; k1 < replaced.size(); k1++) {
+                for (size_t k2 = k1 + 1; k2 < replaced.size(); k2++) {
+                    int si = replaced[k1];
+                    int sj = replaced[k2];
                     canonizeSubexpression(si, sj);
                     potentialSubexpressions.insert({si, sj});
                     potential++;
                 }
             }
-
-            if (sign) {
-                expression.insert(i * sign);
-                expression.insert(j * sign);
-                expression.erase(varIndex * sign);
-            }
         }
 
         double score = pair.second - 1 + scale * (potential - potentialSubexpressions.size());
@@ -368,11 +1116,9 @@ std::pair<int, int> AdditionReducer::selectSubexpressionGreedyPotential(std::mt1
             best = subexpression;
         }
     }
-
-    return best;
 }
 
-std::pair<int, int> AdditionReducer::selectSubexpressionWeightedRandom(std::mt19937 &generator) {
+std::pair<int, int> AdditionReducer::selectSubexpressionWeightedRandom(RandomGenerator &generator) {
     double total = 0;
     for (const auto &pair: subexpressions)
         total += pair.second - 1;
@@ -393,33 +1139,342 @@ std::pair<int, int> AdditionReducer::selectSubexpressionWeightedRandom(std::mt19
     return last;
 }
 
+void AdditionReducer::reduceBeamSearch(RandomGenerator &generator) {
+    std::vector<AdditionReducer> beam(1);
+    beam[0].copyFrom(*this);
+    beam[0].updateSubexpressions();
+
+    AdditionReducer best;
+    best.copyFrom(*this);
+    bool finished = false;
+
+    while (!beam.empty()) {
+        std::vector<AdditionReducer> children;
+        std::vector<std::pair<int, size_t>> scores;
+        std::unordered_set<uint64_t> hashes;
+
+        for (const auto &state : beam) {
+            if (state.maxCount == 0) {
+                if (!finished || state.getAdditions() < best.getAdditions() || (state.getAdditions() == best.getAdditions() && state.getFreshVars() < best.getFreshVars()))
+                    best.copyFrom(state);
+
+                finished = true;
+                continue;
+            }
+
+            for (const auto &subexpression : state.getTopSubexpressions(beamWidth, generator)) {
+                children.emplace_back();
+                AdditionReducer &child = children.back();
+                child.copyFrom(state);
+                child.replaceSubexpression(subexpression);
+
+                // different orders of independent replacements lead to the same state
+                if (!hashes.insert(child.getStateHash()).second) {
+                    children.pop_back();
+                    continue;
+                }
+
+                // score is additions so far minus profit of the best pair of the frequency table
+                child.updateSubexpressions();
+                scores.push_back({child.getAdditions() - std::max(child.maxCount - 1, 0), children.size() - 1});
+            }
+        }
+
+        std::stable_sort(scores.begin(), scores.end(), [](const std::pair<int, size_t> &score1, const std::pair<int, size_t> &score2) {
+            return score1.first < score2.first;
+        });
+
+        beam.clear();
+        for (size_t i = 0; i < scores.size() && i < (size_t) beamWidth; i++)
+            beam.push_back(std::move(children[scores[i].second]));
+    }
+
+    freshVariables = best.freshVariables;
+    expressions = best.expressions;
+    masks = best.masks;
+    sortedRows = best.sortedRows;
+    postings = best.postings;
+    additions = best.additions;
+    maxCount = 0;
+}
+
+std::vector<std::pair<int, int>> AdditionReducer::getTopSubexpressions(size_t count, RandomGenerator &generator) const {
+    std::vector<std::pair<int, std::pair<int, int>>> candidates;
+    candidates.reserve(subexpressions.size());
+
+    for (const auto &pair: subexpressions)
+        candidates.push_back({pair.second, pair.first});
+
+    std::shuffle(candidates.begin(), candidates.end(), generator);
+    count = std::min(count, candidates.size());
+
+    std::partial_sort(candidates.begin(), candidates.begin() + count, candidates.end(), [](const std::pair<int, std::pair<int, int>> &pair1, const std::pair<int, std::pair<int, int>> &pair2) {
+        return pair1.first > pair2.first;
+    });
+
+    std::vector<std::pair<int, int>> top;
+    for (size_t i = 0; i < count; i++)
+        top.push_back(candidates[i].second);
+
+    return top;
+}
+
+int AdditionReducer::countSubexpression(const std::pair<int, int> &subexpression) const {
+    std::vector<int> rows;
+    findRows(subexpression.first, subexpression.second, rows);
+    findRows(-subexpression.first, -subexpression.second, rows);
+
+    int count = 0;
+    for (int row : rows)
+        count += references[row] == 0;
+
+    return count;
+}
+
+uint64_t AdditionReducer::getStateHash() const {
+    std::vector<uint64_t> hashes(realVariables + freshVariables.size() + 1);
+
+    for (int i = 1; i <= realVariables; i++)
+        hashes[i] = RandomGenerator::mix(i);
+
+    auto getHash = [&hashes](int variable) {
+        return variable > 0 ? hashes[variable] : -hashes[-variable];
+    };
+
+    // fresh variable hash depends on its operands only, not on its index
+    for (size_t i = 0; i < freshVariables.size(); i++)
+        hashes[realVariables + i + 1] = RandomGenerator::mix(getHash(freshVariables[i].first) + getHash(freshVariables[i].second));
+
+    uint64_t hash = 0;
+
+    for (const auto &expression: expressions) {
+        uint64_t expressionHash = 0;
+
+        for (int variable : expression)
+            expressionHash += getHash(variable);
+
+        hash = RandomGenerator::mix(hash ^ expressionHash);
+    }
+
+    return hash;
+}
+
 void AdditionReducer::replaceSubexpression(const std::pair<int, int> &subexpression) {
     int varIndex = realVariables + freshVariables.size() + 1;
     int i = subexpression.first;
     int j = subexpression.second;
 
-    for (auto& expression: expressions) {
-        if (expression.size() < 2)
-            continue;
+    // useless fresh variables of external sequences may exceed the width chosen for the scheme
+    if (maskWords && varIndex > 64 * maskWords) {
+        maskWords = 0;
+        masks.clear();
+    }
+
+    if (postings.size() < (size_t) getPostingIndex(-varIndex) + 1)
+        postings.resize(getPostingIndex(-varIndex) + 1);
+
+    switch (maskWords) {
+        case 1: replaceSubexpressionIndexed<1>(i, j, varIndex); break;
+        case 2: replaceSubexpressionIndexed<2>(i, j, varIndex); break;
+        case 4: replaceSubexpressionIndexed<4>(i, j, varIndex); break;
+        case 8: replaceSubexpressionIndexed<8>(i, j, varIndex); break;
+        default: replaceSubexpressionIndexed<0>(i, j, varIndex);
+    }
+
+    freshVariables.push_back({i, j});
+    additions++;
+}
+
+void AdditionReducer::updateIndex() {
+    postings.clear();
+    postings.resize(getPostingIndex(-realVariables - (int) freshVariables.size()) + 1);
+
+    for (size_t index = 0; index < expressions.size(); index++)
+        for (int variable : expressions[index])
+            postings.modify(getPostingIndex(variable)).push_back(index);
+
+    maskWords = WidestVariableMask::getWords(getMaxVariable());
+    sparse = rowStorage == RowStorage::Sparse || (rowStorage == RowStorage::Auto && isSparseDensity());
+
+    if (sparse)
+        maskWords = 0;
+
+    updateSortedRows();
+
+    switch (maskWords) {
+        case 1: updateMasks<1>(); break;
+        case 2: updateMasks<2>(); break;
+        case 4: updateMasks<4>(); break;
+        case 8: updateMasks<8>(); break;
+        default: masks.clear();
+    }
+}
+
+// sorted rows pay off for rows of low density: pairs found in one row only are not hashed, and a row takes less memory than its masks,
+// rows wider than the widest mask have no masks at all, very short rows have too few pairs to gain anything
+bool AdditionReducer::isSparseDensity() const {
+    if (expressions.size() == 0 || realVariables == 0)
+        return false;
+
+    size_t length = 0;
+    for (const auto &expression : expressions)
+        length += expression.size();
+
+    double averageLength = double(length) / expressions.size();
+    return averageLength >= 4 && (maskWords == 0 || averageLength * 8 <= realVariables);
+}
+
+void AdditionReducer::updateSortedRows() {
+    sortedRows.clear();
 
-        const auto end = expression.end();
+    if (!sparse)
+        return;
 
-        if (expression.find(i) != end && expression.find(j) != end) {
-            expression.erase(i);
-            expression.erase(j);
-            expression.insert(varIndex);
+    for (const auto &expression : expressions) {
+        std::vector<int> row(expression.begin(), expression.end());
+        std::sort(row.begin(), row.end(), isSortedBefore);
+
+        sortedRows.push_back(row);
+    }
+}
+
+void AdditionReducer::updateRows(const std::vector<int> &rows) {
+    for (int row : rows) {
+        switch (maskWords) {
+            case 1: updateMask<1>(row); break;
+            case 2: updateMask<2>(row); break;
+            case 4: updateMask<4>(row); break;
+            case 8: updateMask<8>(row); break;
         }
-        else if (expression.find(-i) != end && expression.find(-j) != end) {
-            expression.erase(-i);
-            expression.erase(-j);
-            expression.insert(-varIndex);
+
+        if (sparse) {
+            std::vector<int> sorted(expressions[row].begin(), expressions[row].end());
+            std::sort(sorted.begin(), sorted.end(), isSortedBefore);
+            sortedRows.modify(row) = sorted;
         }
     }
+}
 
-    freshVariables.push_back({i, j});
+// masks are kept in blocks of 64 rows, so a replacement copies only the blocks of its rows from a shared reducer
+template <int Words>
+void AdditionReducer::updateMasks() {
+    masks.clear();
+
+    for (size_t index = 0; index < expressions.size(); index += 64)
+        masks.push_back(std::vector<uint64_t>(64 * VariableMask<Words>::size, 0));
+
+    for (size_t index = 0; index < expressions.size(); index++)
+        updateMask<Words>(index);
+}
+
+template <int Words>
+void AdditionReducer::updateMask(int row) {
+    uint64_t *mask = modifyMask<Words>(row);
+    VariableMask<Words>::clear(mask);
+
+    for (int variable : expressions[row])
+        VariableMask<Words>::insert(mask, variable);
+}
+
+template <int Words>
+const uint64_t* AdditionReducer::getMask(int row) const {
+    return masks[row >> 6].data() + (row & 63) * VariableMask<Words>::size;
+}
+
+template <int Words>
+uint64_t* AdditionReducer::modifyMask(int row) {
+    return masks.modify(row >> 6).data() + (row & 63) * VariableMask<Words>::size;
+}
+
+template <int Words>
+void AdditionReducer::replaceSubexpressionIndexed(int i, int j, int varIndex) {
+    std::vector<int> rows;
+
+    for (int sign = 1; sign >= -1; sign -= 2) {
+        rows.clear();
+        findRows<Words>(i * sign, j * sign, rows);
+        additions -= rows.size();
+
+        for (int row : rows) {
+            auto &expression = expressions.modify(row);
+            expression.erase(i * sign);
+            expression.erase(j * sign);
+            expression.insert(varIndex * sign);
+
+            if (Words) {
+                uint64_t *mask = modifyMask<Words>(row);
+                VariableMask<Words>::erase(mask, i * sign);
+                VariableMask<Words>::erase(mask, j * sign);
+                VariableMask<Words>::insert(mask, varIndex * sign);
+            }
+            else if (sparse) {
+                // the fresh variable is the largest one, so the row stays sorted
+                auto &sorted = sortedRows.modify(row);
+                sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), i * sign, isSortedBefore));
+                sorted.erase(std::lower_bound(sorted.begin(), sorted.end(), j * sign, isSortedBefore));
+                sorted.push_back(varIndex * sign);
+            }
+
+            erasePosting(i * sign, row);
+            erasePosting(j * sign, row);
+            postings.modify(getPostingIndex(varIndex * sign)).push_back(row);
+        }
+    }
+}
+
+void AdditionReducer::findRows(int i, int j, std::vector<int> &rows) const {
+    switch (maskWords) {
+        case 1: findRows<1>(i, j, rows); break;
+        case 2: findRows<2>(i, j, rows); break;
+        case 4: findRows<4>(i, j, rows); break;
+        case 8: findRows<8>(i, j, rows); break;
+        default: findRows<0>(i, j, rows);
+    }
+}
+
+template <int Words>
+void AdditionReducer::findRows(int i, int j, std::vector<int> &rows) const {
+    const std::vector<int> &posting1 = postings[getPostingIndex(i)];
+    const std::vector<int> &posting2 = postings[getPostingIndex(j)];
+
+    // rows of the shorter posting list are checked for the other variable by the mask bit (binary search in sparse rows, hash lookup without masks)
+    bool swapped = posting2.size() < posting1.size();
+    const std::vector<int> &posting = swapped ? posting2 : posting1;
+    int other = swapped ? i : j;
+
+    for (int row : posting) {
+        bool contains;
+
+        if (Words)
+            contains = VariableMask<Words>::get(getMask<Words>(row), other);
+        else if (sparse)
+            contains = std::binary_search(sortedRows[row].begin(), sortedRows[row].end(), other, isSortedBefore);
+        else
+            contains = expressions[row].find(other) != expressions[row].end();
+
+        if (contains)
+            rows.push_back(row);
+    }
+}
+
+// order of sorted rows: by absolute values, a variable before its negation
+bool AdditionReducer::isSortedBefore(int variable1, int variable2) {
+    return abs(variable1) < abs(variable2) || (abs(variable1) == abs(variable2) && variable1 > variable2);
+}
+
+void AdditionReducer::erasePosting(int variable, int row) {
+    std::vector<int> &posting = postings.modify(getPostingIndex(variable));
+    auto it = std::find(posting.begin(), posting.end(), row);
+
+    *it = posting.back();
+    posting.pop_back();
+}
+
+int AdditionReducer::getPostingIndex(int variable) const {
+    return 2 * abs(variable) + (variable < 0);
 }
 
-Strategy AdditionReducer::getStepStrategy(std::mt19937 &generator) {
+Strategy AdditionReducer::getStepStrategy(RandomGenerator &generator) {
     if (strategy == Strategy::Mix)
         return strategyWeights.select(generator);
 
@@ -7,9 +7,18 @@
 #include <string>
 #include <random>
 #include <bitset>
+#include <cmath>
+#include <algorithm>
+#include <numeric>
+#include <map>
 #include <unordered_set>
 #include <unordered_map>
 
+#include "random_generator.h"
+#include "packed_sequence.h"
+#include "variable_mask.h"
+#include "shared_rows.h"
+
 enum class Strategy {
     Greedy,
     GreedyAlternative,
@@ -17,19 +26,36 @@ enum class Strategy {
     WeightedRandom,
     GreedyIntersections,
     GreedyPotential,
+    BeamSearch,
+    LocalSearch,
     Mix
 };
 
+// storage of rows used for membership checks and pair counting, the automatic choice depends on the density of the component
+enum class RowStorage {
+    Auto,
+    Dense,
+    Sparse
+};
+
+// estimated cost of evaluating expressions in order with fresh variables computed right before their first use
+struct MemoryCost {
+    int live; // peak number of simultaneously live fresh variables
+    int traffic; // number of block reads and writes
+};
+
 struct StrategyWeights {
     double greedyAlternative;
     double greedyRandom;
     double weightedRandom;
     double greedyIntersections;
     double greedyPotential;
+    double beamSearch;
     double mix;
+    int beamWidth;
 
     StrategyWeights();
-    Strategy select(std::mt19937 &generator);
+    Strategy select(RandomGenerator &generator);
     double getTotal() const;
 private:
     std::uniform_real_distribution<double> uniformDistribution;
@@ -48,47 +74,119 @@ struct PairHash {
 class AdditionReducer {
     int realVariables;
     int naiveAdditions;
+    int additions; // fresh variables and additions of expressions, updated by every replacement
     int maxCount;
     Strategy strategy;
     StrategyWeights strategyWeights;
     double scale;
     double alpha;
+    int beamWidth;
+    int tasks;
+    bool crossed;
+    bool forked;
+    int maskWords; // words of fixed width masks per sign, 0 for schemes wider than the widest mask and for sparse rows
+    RowStorage rowStorage;
+    bool sparse; // rows are indexed by sorted vectors instead of masks
 
-    std::vector<std::unordered_set<int>> expressions;
-    std::vector<std::pair<int,int>> freshVariables;
+    SharedRows<std::unordered_set<int>> expressions;
+    SharedRows<std::vector<uint64_t>> masks; // blocks of expression masks of maskWords width, kept in sync with expressions
+    SharedRows<std::vector<int>> sortedRows; // expressions sorted by absolute values for sparse rows, kept in sync with expressions
+    SharedRows<std::vector<int>> postings; // rows containing every signed variable, kept in sync with expressions
+    SharedVector<int> references; // 0 for unique rows, +-(index + 1) of the equal (or negated) earlier row for duplicates
+    SharedVector<std::pair<int,int>> freshVariables;
     std::unordered_map<std::pair<int, int>, int, PairHash> subexpressions;
 
     std::uniform_real_distribution<double> uniformDistribution;
-    std::uniform_int_distribution<int> boolDistribution;
+
+    friend class ExactReducer;
 public:
     AdditionReducer();
 
     bool addExpression(const std::vector<int> &expression);
+    int collapseDuplicates();
     void setStrategy(Strategy strategy);
+    void setStrategyWeights(const StrategyWeights &strategyWeights);
+    void setBeamWidth(int beamWidth);
+    void setTasks(int tasks);
+    void setRowStorage(RowStorage rowStorage);
     void partialInitialize(const AdditionReducer &reducer, size_t count);
+    bool applyFreshVariables(const std::vector<std::pair<int, int>> &freshVariables);
+    void crossover(const PackedSequence &parent1, size_t count1, const PackedSequence &parent2);
+    void fork(const AdditionReducer &trunk);
+    bool isPermutation(const AdditionReducer &reducer, const std::vector<int> &permutation) const;
+    bool applyPermutation(const AdditionReducer &reducer, const std::vector<int> &permutation);
 
     void copyFrom(const AdditionReducer &reducer);
-    void reduce(std::mt19937 &generator);
+    void unshare();
+    void reduce(RandomGenerator &generator);
+    void reduceTrunk(RandomGenerator &generator, int steps);
+    void localSearch(RandomGenerator &generator, int steps, size_t fixed);
+    void removeFreshVariables(std::vector<bool> removed, std::vector<int> &expanded);
+    void repair(RandomGenerator &generator, const std::vector<int> &expanded);
     void write(std::ostream &os, const std::string &name, const std::string &indent) const;
 
     int getNaiveAdditions() const;
+    int getDuplicateAdditions() const;
     int getAdditions() const;
     int getFreshVars() const;
+    MemoryCost getMemoryCost() const;
+    int getMaxVariable() const;
+    int getRealVariables() const;
+    bool isSparse() const;
+    uint64_t getStateHash() const;
+    const std::vector<std::pair<int, int>>& getFreshVariables() const;
+    const SharedRows<std::unordered_set<int>>& getExpressions() const;
     std::string getStrategy() const;
 private:
     bool updateSubexpressions();
+    int getTopTies() const;
+    void foldDuplicates();
+    void countSubexpressions(size_t begin, size_t end, std::unordered_map<std::pair<int, int>, int, PairHash> &counts) const;
+    void countSparseSubexpressions(int begin, int end, std::unordered_map<std::pair<int, int>, int, PairHash> &counts) const;
     void canonizeSubexpression(int &i, int &j) const;
-    std::pair<int, int> selectSubexpression(std::mt19937 &generator);
+    std::pair<int, int> selectSubexpression(RandomGenerator &generator);
     void replaceSubexpression(const std::pair<int, int> &subexpression);
+    void countExpandedSubexpressions(const std::vector<int> &expanded);
+    void replaceCountedSubexpression(const std::pair<int, int> &subexpression);
+    void decrementSubexpression(int i, int j);
+    bool updateMaxCount();
     void evaluatePotentialParams();
+    void updateIndex();
+    bool isSparseDensity() const;
+    void updateSortedRows();
+    void updateRows(const std::vector<int> &rows);
+    void findRows(int i, int j, std::vector<int> &rows) const;
+    void erasePosting(int variable, int row);
+    int getPostingIndex(int variable) const;
+    static bool isSortedBefore(int variable1, int variable2);
+
+    template <int Words>
+    void updateMasks();
+    template <int Words>
+    void updateMask(int row);
+    template <int Words>
+    const uint64_t* getMask(int row) const;
+    template <int Words>
+    uint64_t* modifyMask(int row);
+    template <int Words>
+    void replaceSubexpressionIndexed(int i, int j, int varIndex);
+    template <int Words>
+    void findRows(int i, int j, std::vector<int> &rows) const;
 
     std::pair<int, int> selectSubexpressionGreedy();
-    std::pair<int, int> selectSubexpressionGreedyAlternative(std::mt19937 &generator);
-    std::pair<int, int> selectSubexpressionGreedyRandom(std::mt19937 &generator);
-    std::pair<int, int> selectSubexpressionGreedyIntersections(std::mt19937 &generator);
-    std::pair<int, int> selectSubexpressionWeightedRandom(std::mt19937 &generator);
-    std::pair<int, int> selectSubexpressionGreedyPotential(std::mt19937 &generator);
+    std::pair<int, int> selectSubexpressionGreedyAlternative(RandomGenerator &generator);
+    std::pair<int, int> selectSubexpressionGreedyRandom(RandomGenerator &generator);
+    std::pair<int, int> selectSubexpressionGreedyIntersections(RandomGenerator &generator);
+    std::pair<int, int> selectSubexpressionWeightedRandom(RandomGenerator &generator);
+    std::pair<int, int> selectSubexpressionGreedyPotential(RandomGenerator &generator);
+    void scoreIntersections(const std::vector<std::pair<std::pair<int, int>, int>> &candidates, size_t begin, size_t end, RandomGenerator &generator, double &maxScore, std::pair<int, int> &best) const;
+    void scorePotentials(const std::vector<std::pair<std::pair<int, int>, int>> &candidates, size_t begin, size_t end, double &maxScore, std::pair<int, int> &best) const;
+
+    void reduceBeamSearch(RandomGenerator &generator);
+    std::vector<std::pair<int, int>> getTopSubexpressions(size_t count, RandomGenerator &generator) const;
+    int countSubexpression(const std::pair<int, int> &subexpression) const;
 
-    Strategy getStepStrategy(std::mt19937 &generator);
+    Strategy getStepStrategy(RandomGenerator &generator);
+    std::string getStrategyName() const;
     bool isIntersects(const std::pair<int, int> pair1, const std::pair<int, int> &pair2) const;
 };
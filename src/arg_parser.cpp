@@ -4,6 +4,8 @@ ArgParser::ArgParser(const std::string &name, const std::string &description) {
     this->name = name;
     this->description = description;
     this->required = 0;
+    this->output = &std::cout;
+    this->errors = &std::cerr;
 }
 
 void ArgParser::add(const std::string &name, ArgType type, const std::string &meta, const std::string &description, const std::string &value) {
@@ -32,16 +34,17 @@ bool ArgParser::parse(int argc, char *argv[]) {
         std::string name = argv[i];
 
         if (name2arg.find(name) == name2arg.end()) {
-            std::cerr << "unknown argument \"" << name << "\"" << std::endl;
+            *errors << "unknown argument \"" << name << "\"" << std::endl;
             return false;
         }
 
         if (i == argc - 1) {
-            std::cerr << "no value for arg \"" << name << "\"" << std::endl;
+            *errors << "no value for arg \"" << name << "\"" << std::endl;
             return false;
         }
 
         parsed[name] = argv[i + 1];
+        given.insert(name);
 
         if (!validate(name2arg[name], parsed[name]))
             return false;
@@ -51,29 +54,35 @@ bool ArgParser::parse(int argc, char *argv[]) {
 }
 
 void ArgParser::help() {
-    std::cout << description << std::endl;
-    std::cout << "Usage: ./" << name;
+    *output << description << std::endl;
+    *output << "Usage: ./" << name;
 
     for (auto arg : args) {
         if (arg.value != "")
-            std::cout << " [" << arg.name << " " << arg.value << "]";
+            *output << " [" << arg.name << " " << arg.value << "]";
         else
-            std::cout << " " << arg.name << " " << arg.meta;
+            *output << " " << arg.name << " " << arg.meta;
     }
 
-    std::cout << std::endl << std::endl;
-    std::cout << "Arguments description:" << std::endl;
+    *output << std::endl << std::endl;
+    *output << "Arguments description:" << std::endl;
 
     for (auto arg : args) {
-        std::cout << arg.name << ": " << arg.description;
+        *output << arg.name << ": " << arg.description;
 
         if (arg.value != "")
-            std::cout << " (default: " << arg.value << ")";
+            *output << " (default: " << arg.value << ")";
 
-        std::cout << std::endl;
+        *output << std::endl;
     }
 }
 
+// help and errors of parsing go to the given stream instead of stdout and stderr
+void ArgParser::setOutput(std::ostream &os) {
+    this->output = &os;
+    this->errors = &os;
+}
+
 std::string ArgParser::get(const std::string &name) const {
     auto it = parsed.find(name);
     if (it == parsed.end())
@@ -82,17 +91,37 @@ std::string ArgParser::get(const std::string &name) const {
     return it->second;
 }
 
+bool ArgParser::isGiven(const std::string &name) const {
+    return given.find(name) != given.end();
+}
+
+bool ArgParser::set(const std::string &name, const std::string &value) {
+    for (const auto &arg : args) {
+        if (arg.name != name)
+            continue;
+
+        if (!validate(arg, value))
+            return false;
+
+        parsed[name] = value;
+        return true;
+    }
+
+    *errors << "unknown argument \"" << name << "\"" << std::endl;
+    return false;
+}
+
 bool ArgParser::validate(const Arg &arg, const std::string &value) const {
     if (arg.type == ArgType::String)
         return true;
 
     if (arg.type == ArgType::Natural && !isNatural(value)) {
-        std::cerr << "value for arg \"" << arg.name << "\" is not natural (" << value << ")" << std::endl;
+        *errors << "value for arg \"" << arg.name << "\" is not natural (" << value << ")" << std::endl;
         return false;
     }
 
     if (arg.type == ArgType::Real && !isReal(value)) {
-        std::cerr << "value for arg \"" << arg.name << "\" is not real (" << value << ")" << std::endl;
+        *errors << "value for arg \"" << arg.name << "\" is not real (" << value << ")" << std::endl;
         return false;
     }
 
@@ -131,7 +160,7 @@ bool ArgParser::isReal(const std::string &value) const {
 bool ArgParser::checkRequired() const {
     for (auto arg : args) {
         if (arg.value == "" && parsed.find(arg.name) == parsed.end()) {
-            std::cerr << "no value for argument \"" << arg.name << "\"" << std::endl;
+            *errors << "no value for argument \"" << arg.name << "\"" << std::endl;
             return false;
         }
     }
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 enum class ArgType {
@@ -22,7 +23,10 @@ class ArgParser {
     std::string description;
     std::vector<Arg> args;
     std::unordered_map<std::string, std::string> parsed;
+    std::unordered_set<std::string> given;
     int required;
+    std::ostream *output;
+    std::ostream *errors;
 
     bool isNatural(const std::string &value) const;
     bool isReal(const std::string &value) const;
@@ -34,6 +38,9 @@ public:
     void add(const std::string &name, ArgType type, const std::string &meta, const std::string &description = "", const std::string &value = "");
     bool parse(int argc, char *argv[]);
     void help();
+    void setOutput(std::ostream &os);
 
     std::string get(const std::string &name) const;
+    bool isGiven(const std::string &name) const;
+    bool set(const std::string &name, const std::string &value);
 };
@@ -0,0 +1,82 @@
+#include "best_exchange.h"
+
+DirectoryExchange::DirectoryExchange(const std::string &path) {
+    this->path = path;
+}
+
+bool DirectoryExchange::publish(const std::string &name, const ExchangeRecord &record) {
+    return writeRecord(name + "_worker_" + record.worker + ".txt", record);
+}
+
+bool DirectoryExchange::pull(const std::string &name, ExchangeRecord &record, size_t maxFreshVariables) {
+    return readRecord(name + "_best.txt", record, maxFreshVariables);
+}
+
+std::vector<ExchangeRecord> DirectoryExchange::collect(const std::string &name, size_t maxFreshVariables) {
+    std::vector<ExchangeRecord> records;
+    std::string prefix = name + "_worker_";
+
+    DIR *dir = opendir(path.c_str());
+    if (!dir)
+        return records;
+
+    for (struct dirent *entry = readdir(dir); entry != nullptr; entry = readdir(dir)) {
+        std::string filename = entry->d_name;
+
+        if (filename.compare(0, prefix.size(), prefix) != 0 || filename.size() < 4 || filename.compare(filename.size() - 4, 4, ".txt") != 0)
+            continue;
+
+        ExchangeRecord record;
+        if (readRecord(filename, record, maxFreshVariables))
+            records.push_back(record);
+    }
+
+    closedir(dir);
+    return records;
+}
+
+bool DirectoryExchange::store(const std::string &name, const ExchangeRecord &record) {
+    return writeRecord(name + "_best.txt", record);
+}
+
+bool DirectoryExchange::writeRecord(const std::string &filename, const ExchangeRecord &record) const {
+    std::string target = path + "/" + filename;
+    std::string tmp = target + ".tmp" + std::to_string(getpid());
+
+    std::ofstream f(tmp);
+    if (!f)
+        return false;
+
+    f << record.worker << std::endl;
+    f << record.additions << " " << record.freshVars << " " << record.freshVariables.size() << std::endl;
+
+    for (const auto &variable : record.freshVariables)
+        f << variable.first << " " << variable.second << std::endl;
+
+    f.close();
+
+    // rename is atomic, so readers never see partially written records
+    return f && std::rename(tmp.c_str(), target.c_str()) == 0;
+}
+
+bool DirectoryExchange::readRecord(const std::string &filename, ExchangeRecord &record, size_t maxFreshVariables) const {
+    std::ifstream f(path + "/" + filename);
+    if (!f)
+        return false;
+
+    size_t size;
+    if (!(f >> record.worker >> record.additions >> record.freshVars >> size))
+        return false;
+
+    // the count is read from a shared file, so it is checked before anything is allocated for it
+    if (size > maxFreshVariables)
+        return false;
+
+    record.freshVariables.resize(size);
+
+    for (size_t i = 0; i < size; i++)
+        if (!(f >> record.freshVariables[i].first >> record.freshVariables[i].second))
+            return false;
+
+    return true;
+}
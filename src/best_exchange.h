@@ -0,0 +1,44 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdio>
+#include <dirent.h>
+#include <unistd.h>
+
+struct ExchangeRecord {
+    std::string worker;
+    int additions;
+    int freshVars;
+    std::vector<std::pair<int, int>> freshVariables;
+};
+
+// channel for sharing best elimination sequences between worker processes and the coordinator
+class BestExchange {
+public:
+    virtual ~BestExchange() {}
+
+    virtual bool publish(const std::string &name, const ExchangeRecord &record) = 0;
+    // records with more fresh variables than maxFreshVariables are rejected
+    virtual bool pull(const std::string &name, ExchangeRecord &record, size_t maxFreshVariables) = 0;
+    virtual std::vector<ExchangeRecord> collect(const std::string &name, size_t maxFreshVariables) = 0;
+    virtual bool store(const std::string &name, const ExchangeRecord &record) = 0;
+};
+
+// exchange through a shared directory: every worker owns a file per component, the coordinator owns the best file
+class DirectoryExchange : public BestExchange {
+    std::string path;
+public:
+    DirectoryExchange(const std::string &path);
+
+    bool publish(const std::string &name, const ExchangeRecord &record);
+    bool pull(const std::string &name, ExchangeRecord &record, size_t maxFreshVariables);
+    std::vector<ExchangeRecord> collect(const std::string &name, size_t maxFreshVariables);
+    bool store(const std::string &name, const ExchangeRecord &record);
+private:
+    bool writeRecord(const std::string &filename, const ExchangeRecord &record) const;
+    bool readRecord(const std::string &filename, ExchangeRecord &record, size_t maxFreshVariables) const;
+};
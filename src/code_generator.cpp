@@ -0,0 +1,321 @@
+#include "code_generator.h"
+
+CodeGenerator::CodeGenerator(const int *dimension, int rank) {
+    for (int i = 0; i < 3; i++)
+        this->dimension[i] = dimension[i];
+
+    this->rank = rank;
+}
+
+void CodeGenerator::generate(std::ostream &os, const AdditionReducer *reducers) {
+    schedule(reducers);
+    allocate();
+
+    int additions = 0;
+    for (const auto &operation : operations)
+        if (!operation.product)
+            additions += operation.terms.size() - 1;
+
+    int n1 = dimension[0];
+    int n2 = dimension[1];
+    int n3 = dimension[2];
+
+    os << "// " << n1 << "x" << n2 << "x" << n3 << " block matrix multiplication with " << rank << " multiplications and " << additions << " block additions" << std::endl;
+    os << "// generated by ternary_addition_reducer, C (" << n1 << "m x " << n3 << "n) = A (" << n1 << "m x " << n2 << "k) * B (" << n2 << "k x " << n3 << "n), all row-major" << std::endl;
+    os << "#pragma once" << std::endl;
+    os << std::endl;
+    os << "#include <cstddef>" << std::endl;
+    os << "#include <vector>" << std::endl;
+    os << std::endl;
+    // loops are vectorized by OpenMP only when it is enabled, so compilers without -fopenmp do not warn about unknown pragmas
+    os << "#ifndef REDUCED_SCHEME_SIMD" << std::endl;
+    os << "#ifdef _OPENMP" << std::endl;
+    os << "#define REDUCED_SCHEME_SIMD _Pragma(\"omp simd\")" << std::endl;
+    os << "#else" << std::endl;
+    os << "#define REDUCED_SCHEME_SIMD" << std::endl;
+    os << "#endif" << std::endl;
+    os << "#endif" << std::endl;
+    os << std::endl;
+    os << "namespace reduced_scheme {" << std::endl;
+    os << std::endl;
+    os << "const int n1 = " << n1 << ";" << std::endl;
+    os << "const int n2 = " << n2 << ";" << std::endl;
+    os << "const int n3 = " << n3 << ";" << std::endl;
+    os << "const int rank = " << rank << ";" << std::endl;
+    os << "const int additions = " << additions << ";" << std::endl;
+    os << "const int buffers[3] = {" << buffers[0] << ", " << buffers[1] << ", " << buffers[2] << "};" << std::endl;
+    os << std::endl;
+    os << "template <typename T>" << std::endl;
+    os << "void gemm(T *c, const T *a, const T *b, size_t m, size_t k, size_t n) {" << std::endl;
+    os << "    for (size_t i = 0; i < m * n; i++)" << std::endl;
+    os << "        c[i] = 0;" << std::endl;
+    os << std::endl;
+    os << "    for (size_t i = 0; i < m; i++) {" << std::endl;
+    os << "        for (size_t l = 0; l < k; l++) {" << std::endl;
+    os << "            const T value = a[i * k + l];" << std::endl;
+    os << "            const T *row = b + l * n;" << std::endl;
+    os << "            T *target = c + i * n;" << std::endl;
+    os << std::endl;
+    os << "            REDUCED_SCHEME_SIMD" << std::endl;
+    os << "            for (size_t j = 0; j < n; j++)" << std::endl;
+    os << "                target[j] += value * row[j];" << std::endl;
+    os << "        }" << std::endl;
+    os << "    }" << std::endl;
+    os << "}" << std::endl;
+    os << std::endl;
+    os << "template <typename T>" << std::endl;
+    os << "void pack(T **blocks, const T *matrix, int blockRows, int blockColumns, size_t rows, size_t columns) {" << std::endl;
+    os << "    for (int p = 0; p < blockRows; p++)" << std::endl;
+    os << "        for (int q = 0; q < blockColumns; q++)" << std::endl;
+    os << "            for (size_t i = 0; i < rows; i++)" << std::endl;
+    os << "                for (size_t j = 0; j < columns; j++)" << std::endl;
+    os << "                    blocks[p * blockColumns + q][i * columns + j] = matrix[(p * rows + i) * blockColumns * columns + q * columns + j];" << std::endl;
+    os << "}" << std::endl;
+    os << std::endl;
+    os << "template <typename T>" << std::endl;
+    os << "void unpack(T *matrix, T **blocks, int blockRows, int blockColumns, size_t rows, size_t columns) {" << std::endl;
+    os << "    for (int p = 0; p < blockRows; p++)" << std::endl;
+    os << "        for (int q = 0; q < blockColumns; q++)" << std::endl;
+    os << "            for (size_t i = 0; i < rows; i++)" << std::endl;
+    os << "                for (size_t j = 0; j < columns; j++)" << std::endl;
+    os << "                    matrix[(p * rows + i) * blockColumns * columns + q * columns + j] = blocks[p * blockColumns + q][i * columns + j];" << std::endl;
+    os << "}" << std::endl;
+    os << std::endl;
+    os << "template <typename T>" << std::endl;
+    os << "void multiply(const T *A, const T *B, T *C, size_t m, size_t k, size_t n) {" << std::endl;
+    os << "    const size_t sizes[3] = {m * k, k * n, m * n};" << std::endl;
+    os << "    std::vector<T> memory(sizes[0] * (n1 * n2 + buffers[0]) + sizes[1] * (n2 * n3 + buffers[1]) + sizes[2] * (n3 * n1 + buffers[2]));" << std::endl;
+    os << "    T *a[n1 * n2], *b[n2 * n3], *c[n3 * n1];" << std::endl;
+    os << "    T *ta[buffers[0] + 1], *tb[buffers[1] + 1], *tc[buffers[2] + 1];" << std::endl;
+    os << "    T *pointer = memory.data();" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < n1 * n2; i++, pointer += sizes[0])" << std::endl;
+    os << "        a[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < n2 * n3; i++, pointer += sizes[1])" << std::endl;
+    os << "        b[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < n3 * n1; i++, pointer += sizes[2])" << std::endl;
+    os << "        c[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < buffers[0]; i++, pointer += sizes[0])" << std::endl;
+    os << "        ta[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < buffers[1]; i++, pointer += sizes[1])" << std::endl;
+    os << "        tb[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    for (int i = 0; i < buffers[2]; i++, pointer += sizes[2])" << std::endl;
+    os << "        tc[i] = pointer;" << std::endl;
+    os << std::endl;
+    os << "    pack(a, A, n1, n2, m, k);" << std::endl;
+    os << "    pack(b, B, n2, n3, k, n);" << std::endl;
+    os << std::endl;
+
+    for (const auto &operation : operations)
+        emitOperation(os, operation);
+
+    os << "    unpack(C, c, n1, n3, m, n);" << std::endl;
+    os << "}" << std::endl;
+    os << std::endl;
+    os << "}" << std::endl;
+}
+
+void CodeGenerator::schedule(const AdditionReducer *reducers) {
+    values.clear();
+    operations.clear();
+
+    for (int i = 0; i < 3; i++)
+        refs[i] = std::vector<KernelRef>(reducers[i].getRealVariables() + reducers[i].getFreshVariables().size() + 1, {-1, 1});
+
+    for (int i = 0; i < 2; i++)
+        for (int variable = 1; variable <= reducers[i].getRealVariables(); variable++)
+            refs[i][variable] = {addValue(i, variable - 1), 1};
+
+    const auto &expressionsW = reducers[2].getExpressions();
+    const auto &freshW = reducers[2].getFreshVariables();
+    int realW = reducers[2].getRealVariables();
+    std::vector<bool> outputs(expressionsW.size(), false);
+
+    // every product is computed as soon as possible, fresh variables of W and blocks of C right after their operands
+    for (int index = 0; index < rank; index++) {
+        KernelRef u = combine(reducers[0], 0, getSorted(reducers[0].getExpressions()[index]));
+        KernelRef v = combine(reducers[1], 1, getSorted(reducers[1].getExpressions()[index]));
+
+        int value = addValue(2, -1);
+        operations.push_back({value, -1, true, {{u.value, 1}, {v.value, 1}}});
+        refs[2][index + 1] = {value, u.sign * v.sign};
+
+        for (size_t i = 0; i < freshW.size(); i++)
+            if (refs[2][realW + i + 1].value < 0 && isReady(2, freshW[i].first) && isReady(2, freshW[i].second))
+                require(reducers[2], 2, realW + i + 1);
+
+        for (size_t i = 0; i < expressionsW.size(); i++) {
+            if (outputs[i])
+                continue;
+
+            std::vector<int> expression = getSorted(expressionsW[i]);
+            bool ready = true;
+
+            for (int variable : expression)
+                ready &= isReady(2, variable);
+
+            if (!ready)
+                continue;
+
+            std::vector<std::pair<int, int>> terms;
+            for (int variable : expression) {
+                KernelRef ref = require(reducers[2], 2, variable);
+                terms.push_back({ref.value, ref.sign});
+            }
+
+            int row = i % dimension[0];
+            int column = i / dimension[0];
+            operations.push_back({-1, row * dimension[2] + column, false, terms});
+            outputs[i] = true;
+        }
+    }
+}
+
+void CodeGenerator::allocate() {
+    std::vector<int> lastUse(values.size(), -1);
+
+    for (size_t i = 0; i < operations.size(); i++) {
+        if (operations[i].target >= 0)
+            lastUse[operations[i].target] = i;
+
+        for (const auto &term : operations[i].terms)
+            lastUse[term.first] = i;
+    }
+
+    std::vector<int> free[3];
+    for (int i = 0; i < 3; i++)
+        buffers[i] = 0;
+
+    auto release = [this, &lastUse, &free](const KernelOperation &operation, int index) {
+        for (const auto &term : operation.terms) {
+            KernelValue &value = values[term.first];
+
+            if (value.input < 0 && lastUse[term.first] == index && value.buffer >= 0 && std::find(free[value.pool].begin(), free[value.pool].end(), value.buffer) == free[value.pool].end())
+                free[value.pool].push_back(value.buffer);
+        }
+    };
+
+    // dead buffers are reused, elementwise additions may also write into their own dying operand
+    for (size_t i = 0; i < operations.size(); i++) {
+        const KernelOperation &operation = operations[i];
+
+        if (!operation.product)
+            release(operation, i);
+
+        if (operation.target >= 0) {
+            KernelValue &value = values[operation.target];
+
+            if (free[value.pool].empty()) {
+                value.buffer = buffers[value.pool]++;
+            }
+            else {
+                value.buffer = free[value.pool].back();
+                free[value.pool].pop_back();
+            }
+
+            if (lastUse[operation.target] == (int) i)
+                free[value.pool].push_back(value.buffer);
+        }
+
+        if (operation.product)
+            release(operation, i);
+    }
+}
+
+void CodeGenerator::emitOperation(std::ostream &os, const KernelOperation &operation) const {
+    if (operation.product) {
+        os << "    gemm(" << getName(operation.target) << ", " << getName(operation.terms[0].first) << ", " << getName(operation.terms[1].first) << ", m, k, n);" << std::endl;
+        return;
+    }
+
+    int pool = operation.target >= 0 ? values[operation.target].pool : 2;
+    std::string target = operation.target >= 0 ? getName(operation.target) : "c[" + std::to_string(operation.output) + "]";
+
+    os << std::endl;
+    os << "    REDUCED_SCHEME_SIMD" << std::endl;
+    os << "    for (size_t i = 0; i < sizes[" << pool << "]; i++)" << std::endl;
+    os << "        " << target << "[i] =";
+
+    if (operation.terms.empty())
+        os << " 0";
+
+    for (size_t i = 0; i < operation.terms.size(); i++) {
+        if (operation.terms[i].second < 0)
+            os << (i == 0 ? " -" : " - ");
+        else if (i > 0)
+            os << " + ";
+        else
+            os << " ";
+
+        os << getName(operation.terms[i].first) << "[i]";
+    }
+
+    os << ";" << std::endl;
+    os << std::endl;
+}
+
+int CodeGenerator::addValue(int pool, int input) {
+    values.push_back({pool, input, -1});
+    return values.size() - 1;
+}
+
+KernelRef CodeGenerator::require(const AdditionReducer &reducer, int component, int variable) {
+    int index = abs(variable);
+    int sign = variable > 0 ? 1 : -1;
+
+    if (refs[component][index].value < 0) {
+        const auto &subexpression = reducer.getFreshVariables()[index - reducer.getRealVariables() - 1];
+        refs[component][index] = combine(reducer, component, {subexpression.first, subexpression.second});
+    }
+
+    return {refs[component][index].value, refs[component][index].sign * sign};
+}
+
+KernelRef CodeGenerator::combine(const AdditionReducer &reducer, int component, const std::vector<int> &expression) {
+    if (expression.size() == 1)
+        return require(reducer, component, expression[0]);
+
+    std::vector<std::pair<int, int>> terms;
+    for (int variable : expression) {
+        KernelRef ref = require(reducer, component, variable);
+        terms.push_back({ref.value, ref.sign});
+    }
+
+    // positive term goes first, so the block is computed without extra negation
+    std::stable_sort(terms.begin(), terms.end(), [](const std::pair<int, int> &term1, const std::pair<int, int> &term2) {
+        return term1.second > term2.second;
+    });
+
+    int value = addValue(component, -1);
+    operations.push_back({value, -1, false, terms});
+    return {value, 1};
+}
+
+bool CodeGenerator::isReady(int component, int variable) const {
+    return refs[component][abs(variable)].value >= 0;
+}
+
+std::vector<int> CodeGenerator::getSorted(const std::unordered_set<int> &expression) const {
+    std::vector<int> sorted(expression.begin(), expression.end());
+
+    std::sort(sorted.begin(), sorted.end(), [](int variable1, int variable2) {
+        return abs(variable1) < abs(variable2);
+    });
+
+    return sorted;
+}
+
+std::string CodeGenerator::getName(int value) const {
+    const KernelValue &kernelValue = values[value];
+    std::string pool = std::string(1, "abc"[kernelValue.pool]);
+
+    if (kernelValue.input >= 0)
+        return pool + "[" + std::to_string(kernelValue.input) + "]";
+
+    return "t" + pool + "[" + std::to_string(kernelValue.buffer) + "]";
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+
+#include "addition_reducer.h"
+
+struct KernelValue {
+    int pool; // 0 - blocks of A, 1 - blocks of B, 2 - blocks of C
+    int input; // index of packed input block, -1 for temporary values
+    int buffer;
+};
+
+struct KernelOperation {
+    int target; // value index, -1 for output block
+    int output;
+    bool product;
+    std::vector<std::pair<int, int>> terms; // value index and sign
+};
+
+// reference to the mathematical value of a variable: sign * data of the value
+struct KernelRef {
+    int value;
+    int sign;
+};
+
+// straight-line C++ code of one level block matrix multiplication by the reduced scheme
+class CodeGenerator {
+    int dimension[3];
+    int rank;
+
+    std::vector<KernelValue> values;
+    std::vector<KernelOperation> operations;
+    std::vector<KernelRef> refs[3];
+    int buffers[3];
+public:
+    CodeGenerator(const int *dimension, int rank);
+
+    void generate(std::ostream &os, const AdditionReducer *reducers);
+private:
+    void schedule(const AdditionReducer *reducers);
+    void allocate();
+    void emitOperation(std::ostream &os, const KernelOperation &operation) const;
+
+    int addValue(int pool, int input);
+    KernelRef require(const AdditionReducer &reducer, int component, int variable);
+    KernelRef combine(const AdditionReducer &reducer, int component, const std::vector<int> &expression);
+    bool isReady(int component, int variable) const;
+    std::vector<int> getSorted(const std::unordered_set<int> &expression) const;
+    std::string getName(int value) const;
+};
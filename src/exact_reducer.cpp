@@ -0,0 +1,198 @@
+#include "exact_reducer.h"
+
+ExactReducer::ExactReducer(long maxNodes, int taskDepth) {
+    this->maxNodes = maxNodes;
+    this->taskDepth = taskDepth;
+    this->upperBound = 0;
+    this->nodes = 0;
+    this->aborted = false;
+    this->improved = false;
+}
+
+bool ExactReducer::solve(const AdditionReducer &initial, const AdditionReducer &incumbent) {
+    AdditionReducer root;
+    root.copyFrom(initial);
+    best.copyFrom(incumbent);
+
+    upperBound = incumbent.getAdditions();
+    nodes = 0;
+    aborted = false;
+    improved = false;
+    visited.clear();
+
+    // subtrees of first levels are tasks, idle threads take them from the task pool
+    #pragma omp parallel
+    #pragma omp single
+    search(root, {0, 0}, 0);
+
+    return !aborted;
+}
+
+bool ExactReducer::isImproved() const {
+    return improved;
+}
+
+long ExactReducer::getNodes() const {
+    return nodes;
+}
+
+const AdditionReducer& ExactReducer::getBest() const {
+    return best;
+}
+
+void ExactReducer::search(AdditionReducer &state, const std::pair<int, int> &last, int depth) {
+    long node;
+    #pragma omp atomic capture
+    node = ++nodes;
+
+    if (node > maxNodes) {
+        #pragma omp atomic write
+        aborted = true;
+        return;
+    }
+
+    bool hasPairs = state.updateSubexpressions();
+    int lowerBound = getLowerBound(state);
+
+    int bound;
+    #pragma omp atomic read
+    bound = upperBound;
+
+    if (!hasPairs) {
+        #pragma omp critical(exact_best)
+        if (lowerBound < upperBound) {
+            upperBound = lowerBound;
+            best.copyFrom(state);
+            best.foldDuplicates();
+            improved = true;
+        }
+
+        return;
+    }
+
+    if (lowerBound >= bound)
+        return;
+
+    // pruning of commuting replacements depends on the last one, so it is a part of the visited key
+    bool isNew;
+    uint64_t hash = RandomGenerator::mix(state.getStateHash() ^ RandomGenerator::mix(((uint64_t) last.first << 32) ^ (uint32_t) last.second));
+
+    #pragma omp critical(exact_visited)
+    isNew = visited.insert(hash).second;
+
+    if (!isNew)
+        return;
+
+    int lastVariable = state.realVariables + state.freshVariables.size();
+
+    for (const auto &subexpression : getCandidates(state)) {
+        bool stop;
+        #pragma omp atomic read
+        stop = aborted;
+
+        if (stop)
+            break;
+
+        // replacements with disjoint operands commute, so only the increasing order of them is explored
+        if (depth > 0 && subexpression < last && isIndependent(subexpression, last, lastVariable))
+            continue;
+
+        AdditionReducer child(state);
+        child.replaceSubexpression(subexpression);
+
+        if (depth < taskDepth) {
+            #pragma omp task firstprivate(child, subexpression)
+            search(child, subexpression, depth + 1);
+        }
+        else {
+            search(child, subexpression, depth + 1);
+        }
+    }
+
+    #pragma omp taskwait
+}
+
+int ExactReducer::getLowerBound(const AdditionReducer &state) const {
+    // rows without repeated pairs never change, every other row with a distinct (up to sign) value needs at least one more addition
+    int bound = state.freshVariables.size();
+    std::vector<uint64_t> values = getValueHashes(state);
+    std::unordered_set<uint64_t> rows;
+
+    for (size_t index = 0; index < state.expressions.size(); index++) {
+        const auto &expression = state.expressions[index];
+
+        // duplicates are folded with their referenced row for free
+        if (expression.size() < 2 || state.references[index])
+            continue;
+
+        bool frozen = true;
+
+        for (auto it1 = expression.begin(); it1 != expression.end() && frozen; it1++) {
+            for (auto it2 = std::next(it1); it2 != expression.end() && frozen; it2++) {
+                int i = *it1;
+                int j = *it2;
+                state.canonizeSubexpression(i, j);
+
+                if (state.subexpressions.find({i, j}) != state.subexpressions.end())
+                    frozen = false;
+            }
+        }
+
+        if (frozen) {
+            bound += expression.size() - 1;
+            continue;
+        }
+
+        uint64_t value = 0;
+        for (int variable : expression)
+            value += variable > 0 ? values[variable] : -values[-variable];
+
+        rows.insert(std::min(value, -value));
+    }
+
+    return bound + rows.size();
+}
+
+std::vector<uint64_t> ExactReducer::getValueHashes(const AdditionReducer &state) const {
+    // linear hash of the expanded value, so rows equal through fresh variables are not counted twice
+    std::vector<uint64_t> values(state.realVariables + state.freshVariables.size() + 1, 0);
+
+    for (int variable = 1; variable <= state.realVariables; variable++)
+        values[variable] = RandomGenerator::mix(variable);
+
+    for (size_t k = 0; k < state.freshVariables.size(); k++) {
+        int i = state.freshVariables[k].first;
+        int j = state.freshVariables[k].second;
+        values[state.realVariables + k + 1] = values[i] + (j > 0 ? values[j] : -values[-j]);
+    }
+
+    return values;
+}
+
+std::vector<std::pair<int, int>> ExactReducer::getCandidates(const AdditionReducer &state) const {
+    std::vector<std::pair<int, std::pair<int, int>>> candidates;
+
+    for (const auto &pair : state.subexpressions)
+        candidates.push_back({-pair.second, pair.first});
+
+    // most frequent subexpressions first give good incumbents early
+    std::sort(candidates.begin(), candidates.end());
+
+    std::vector<std::pair<int, int>> subexpressions;
+    for (const auto &candidate : candidates)
+        subexpressions.push_back(candidate.second);
+
+    return subexpressions;
+}
+
+// a replacement sharing an operand with the last one (or using its fresh variable) takes that operand from the rows of the other,
+// so only replacements with disjoint operands give the same state in both orders
+bool ExactReducer::isIndependent(const std::pair<int, int> &subexpression, const std::pair<int, int> &last, int variable) const {
+    int operands[] = {abs(last.first), abs(last.second), variable};
+
+    for (int operand : operands)
+        if (abs(subexpression.first) == operand || abs(subexpression.second) == operand)
+            return false;
+
+    return true;
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <unordered_set>
+#include <omp.h>
+
+#include "addition_reducer.h"
+
+// branch and bound over subexpression selections, proves optimality of the incumbent if search is completed
+class ExactReducer {
+    AdditionReducer best;
+    long maxNodes;
+    int taskDepth;
+
+    int upperBound;
+    long nodes;
+    bool aborted;
+    bool improved;
+    std::unordered_set<uint64_t> visited;
+public:
+    ExactReducer(long maxNodes, int taskDepth = 3);
+
+    bool solve(const AdditionReducer &initial, const AdditionReducer &incumbent);
+    bool isImproved() const;
+    long getNodes() const;
+    const AdditionReducer& getBest() const;
+private:
+    void search(AdditionReducer &state, const std::pair<int, int> &last, int depth);
+    int getLowerBound(const AdditionReducer &state) const;
+    std::vector<uint64_t> getValueHashes(const AdditionReducer &state) const;
+    std::vector<std::pair<int, int>> getCandidates(const AdditionReducer &state) const;
+    bool isIndependent(const std::pair<int, int> &subexpression, const std::pair<int, int> &last, int variable) const;
+};
@@ -0,0 +1,207 @@
+#include "job_server.h"
+
+SocketBuffer::SocketBuffer(int fd) {
+    this->fd = fd;
+
+    setg(input, input, input);
+    setp(output, output + sizeof(output));
+}
+
+int SocketBuffer::underflow() {
+    if (gptr() < egptr())
+        return traits_type::to_int_type(*gptr());
+
+    ssize_t size = read(fd, input, sizeof(input));
+    if (size <= 0)
+        return traits_type::eof();
+
+    setg(input, input, input + size);
+    return traits_type::to_int_type(*gptr());
+}
+
+int SocketBuffer::overflow(int c) {
+    sync();
+
+    if (c != traits_type::eof()) {
+        *pptr() = c;
+        pbump(1);
+    }
+
+    return traits_type::not_eof(c);
+}
+
+// a disconnected client does not stop its job, the rest of the output is dropped
+int SocketBuffer::sync() {
+    char *start = pbase();
+
+    while (start < pptr()) {
+        ssize_t size = send(fd, start, pptr() - start, MSG_NOSIGNAL);
+        if (size <= 0)
+            break;
+
+        start += size;
+    }
+
+    setp(output, output + sizeof(output));
+    return 0;
+}
+
+JobServer::JobServer(const std::string &path, int workers, const JobHandler &handler) {
+    this->path = path;
+    this->workers = std::max(1, workers);
+    this->handler = handler;
+
+    listenFd = -1;
+    stopped = false;
+    jobs = 0;
+}
+
+bool JobServer::listen(std::ostream &os) {
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+
+    if (path.size() >= sizeof(address.sun_path)) {
+        os << "Socket path \"" << path << "\" is too long" << std::endl;
+        return false;
+    }
+
+    strcpy(address.sun_path, path.c_str());
+
+    // socket file of a previous server is removed, bind fails on existing files
+    unlink(path.c_str());
+    listenFd = socket(AF_UNIX, SOCK_STREAM, 0);
+
+    if (listenFd < 0 || bind(listenFd, (sockaddr *) &address, sizeof(address)) != 0 || ::listen(listenFd, SOMAXCONN) != 0) {
+        os << "Unable to listen socket \"" << path << "\"" << std::endl;
+
+        if (listenFd >= 0)
+            close(listenFd);
+
+        return false;
+    }
+
+    int threads = std::max(1, omp_get_max_threads() / workers);
+    os << "Server listens socket \"" << path << "\" with " << workers << " workers of " << threads << " threads" << std::endl;
+
+    std::vector<std::thread> pool;
+    for (int worker = 0; worker < workers; worker++)
+        pool.emplace_back(&JobServer::work, this, worker, threads, std::ref(os));
+
+    while (true) {
+        int fd = accept(listenFd, nullptr, nullptr);
+        if (fd < 0) {
+            if (errno == EINTR)
+                continue;
+
+            break;
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        if (stopped) {
+            close(fd);
+            break;
+        }
+
+        int job = ++jobs;
+        queue.push_back({job, fd});
+
+        std::string message = "Job " + std::to_string(job) + " queued (position " + std::to_string(queue.size()) + ")\n";
+        send(fd, message.c_str(), message.size(), MSG_NOSIGNAL);
+        os << "Job " << job << " queued (position " << queue.size() << ")" << std::endl;
+        condition.notify_one();
+    }
+
+    // queued jobs are finished before the workers exit
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stopped = true;
+    }
+
+    condition.notify_all();
+
+    for (auto &thread : pool)
+        thread.join();
+
+    close(listenFd);
+    unlink(path.c_str());
+    os << "Server stopped after " << jobs << " jobs" << std::endl;
+    return true;
+}
+
+void JobServer::serve(std::istream &is, std::ostream &os) {
+    std::string line;
+
+    while (!stopped && std::getline(is, line)) {
+        if (line.find_first_not_of(" \t\r") == std::string::npos)
+            continue;
+
+        int job = ++jobs;
+        int code = runJob(line, is, os);
+        os << "Job " << job << " finished with code " << code << std::endl;
+    }
+}
+
+void JobServer::work(int worker, int threads, std::ostream &log) {
+    // the number of threads is an internal variable of the calling thread, the team of the worker is kept between its jobs
+    omp_set_num_threads(threads);
+
+    while (true) {
+        std::pair<int, int> job;
+
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            condition.wait(lock, [this] { return stopped || !queue.empty(); });
+
+            if (queue.empty())
+                return;
+
+            job = queue.front();
+            queue.pop_front();
+            log << "Job " << job.first << " started on worker " << worker << std::endl;
+        }
+
+        SocketBuffer buffer(job.second);
+        std::iostream stream(&buffer);
+        std::string line;
+        std::getline(stream, line);
+
+        int code = runJob(line, stream, stream);
+        stream << "Job " << job.first << " finished with code " << code << std::endl;
+        close(job.second);
+
+        std::unique_lock<std::mutex> lock(mutex);
+        log << "Job " << job.first << " finished with code " << code << std::endl;
+    }
+}
+
+int JobServer::runJob(const std::string &line, std::istream &is, std::ostream &os) {
+    std::vector<std::string> args;
+    std::stringstream ss(line);
+    std::string arg;
+
+    while (ss >> arg)
+        args.push_back(arg);
+
+    if (args.size() == 1 && args[0] == "shutdown") {
+        os << "Server is stopping, queued jobs are finished" << std::endl;
+        stop();
+        return 0;
+    }
+
+    try {
+        return handler(args, is, os);
+    }
+    catch (const std::exception &e) {
+        os << "Job failed: " << e.what() << std::endl;
+        return -1;
+    }
+}
+
+void JobServer::stop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    stopped = true;
+
+    if (listenFd >= 0)
+        shutdown(listenFd, SHUT_RDWR);
+}
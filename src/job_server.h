@@ -0,0 +1,58 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <omp.h>
+
+// runs one job with its arguments, reads the job input from the stream and writes progress and results to the stream
+typedef std::function<int(const std::vector<std::string> &args, std::istream &is, std::ostream &os)> JobHandler;
+
+// stream buffer of a connected socket, every flush of the stream sends the written lines to the client
+class SocketBuffer : public std::streambuf {
+    int fd;
+    char input[4096];
+    char output[4096];
+public:
+    SocketBuffer(int fd);
+protected:
+    int underflow();
+    int overflow(int c);
+    int sync();
+};
+
+// server keeping worker threads with their OpenMP teams between jobs: a job is a line of arguments followed by its input,
+// jobs wait in a queue and the workers run them concurrently, every worker gets an equal share of the threads
+class JobServer {
+    std::string path;
+    int workers;
+    JobHandler handler;
+
+    int listenFd;
+    bool stopped;
+    int jobs;
+    std::deque<std::pair<int, int>> queue;
+    std::mutex mutex;
+    std::condition_variable condition;
+public:
+    JobServer(const std::string &path, int workers, const JobHandler &handler);
+
+    bool listen(std::ostream &os);
+    void serve(std::istream &is, std::ostream &os);
+private:
+    void work(int worker, int threads, std::ostream &log);
+    int runJob(const std::string &line, std::istream &is, std::ostream &os);
+    void stop();
+};
@@ -0,0 +1,100 @@
+#include "numa_topology.h"
+
+NumaTopology::NumaTopology() {
+    nodes = 0;
+
+    for (int node = 0; ; node++) {
+        std::ifstream f("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        if (!f)
+            break;
+
+        std::string list;
+        std::getline(f, list);
+
+        for (int cpu : parseCpuList(list)) {
+            if (cpu >= (int) cpuNodes.size())
+                cpuNodes.resize(cpu + 1, 0);
+
+            cpuNodes[cpu] = node;
+        }
+
+        nodes++;
+    }
+
+    if (nodes == 0)
+        nodes = 1;
+}
+
+int NumaTopology::getNodes() const {
+    return nodes;
+}
+
+int NumaTopology::getNode(int cpu) const {
+    if (cpu < 0 || cpu >= (int) cpuNodes.size())
+        return 0;
+
+    return cpuNodes[cpu];
+}
+
+int NumaTopology::getCurrentNode() const {
+    if (nodes == 1)
+        return 0;
+
+    return getNode(sched_getcpu());
+}
+
+bool NumaTopology::pinThreads() const {
+    cpu_set_t available;
+    CPU_ZERO(&available);
+
+    if (sched_getaffinity(0, sizeof(available), &available) != 0)
+        return false;
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; cpu++)
+        if (CPU_ISSET(cpu, &available))
+            cpus.push_back(cpu);
+
+    if (cpus.empty())
+        return false;
+
+    // consecutive threads fill one node before the next, so neighbouring tasks share memory
+    std::stable_sort(cpus.begin(), cpus.end(), [this](int cpu1, int cpu2) {
+        return getNode(cpu1) < getNode(cpu2);
+    });
+
+    bool pinned = true;
+
+    #pragma omp parallel reduction(&&: pinned)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &set);
+        pinned = sched_setaffinity(0, sizeof(set), &set) == 0;
+    }
+
+    return pinned;
+}
+
+std::vector<int> NumaTopology::parseCpuList(const std::string &list) const {
+    std::vector<int> cpus;
+    std::stringstream ss(list);
+    std::string range;
+
+    while (std::getline(ss, range, ',')) {
+        size_t dash = range.find('-');
+
+        try {
+            int first = std::stoi(range.substr(0, dash));
+            int last = dash == std::string::npos ? first : std::stoi(range.substr(dash + 1));
+
+            for (int cpu = first; cpu <= last; cpu++)
+                cpus.push_back(cpu);
+        }
+        catch (const std::exception &) {
+            continue;
+        }
+    }
+
+    return cpus;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <sched.h>
+#include <omp.h>
+
+// NUMA nodes of the machine read from sysfs, single node if information is unavailable
+class NumaTopology {
+    std::vector<int> cpuNodes;
+    int nodes;
+public:
+    NumaTopology();
+
+    int getNodes() const;
+    int getNode(int cpu) const;
+    int getCurrentNode() const;
+    bool pinThreads() const;
+private:
+    std::vector<int> parseCpuList(const std::string &list) const;
+};
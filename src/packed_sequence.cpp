@@ -0,0 +1,34 @@
+#include "packed_sequence.h"
+
+PackedSequence::PackedSequence() {
+}
+
+PackedSequence::PackedSequence(const std::vector<std::pair<int, int>> &freshVariables) {
+    operands.reserve(freshVariables.size() * 2);
+
+    for (const auto &variable : freshVariables) {
+        operands.push_back(variable.first);
+        operands.push_back(variable.second);
+    }
+}
+
+size_t PackedSequence::size() const {
+    return operands.size() / 2;
+}
+
+std::pair<int, int> PackedSequence::operator[](size_t index) const {
+    return {operands[index * 2], operands[index * 2 + 1]};
+}
+
+std::vector<std::pair<int, int>> PackedSequence::unpack() const {
+    std::vector<std::pair<int, int>> freshVariables(size());
+
+    for (size_t i = 0; i < freshVariables.size(); i++)
+        freshVariables[i] = (*this)[i];
+
+    return freshVariables;
+}
+
+bool PackedSequence::canPack(int maxVariable) {
+    return maxVariable <= INT16_MAX;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+
+// compact storage of fresh variables sequence: two signed 16-bit operands per variable
+class PackedSequence {
+    std::vector<int16_t> operands;
+public:
+    PackedSequence();
+    PackedSequence(const std::vector<std::pair<int, int>> &freshVariables);
+
+    size_t size() const;
+    std::pair<int, int> operator[](size_t index) const;
+    std::vector<std::pair<int, int>> unpack() const;
+
+    static bool canPack(int maxVariable);
+};
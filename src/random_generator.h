@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdint>
+
+// SplitMix64 counter based generator: every (seed, stream) pair gives an independent sequence,
+// so results do not depend on the thread executing the task
+class RandomGenerator {
+    uint64_t state;
+    uint64_t bits;
+    int bitsCount;
+public:
+    typedef uint64_t result_type;
+
+    RandomGenerator(uint64_t seed = 0, uint64_t stream = 0) {
+        state = mix(seed ^ mix(stream + 0x9E3779B97F4A7C15ULL));
+        bits = 0;
+        bitsCount = 0;
+    }
+
+    static constexpr result_type min() {
+        return 0;
+    }
+
+    static constexpr result_type max() {
+        return UINT64_MAX;
+    }
+
+    result_type operator()() {
+        state += 0x9E3779B97F4A7C15ULL;
+        return mix(state);
+    }
+
+    bool bit() {
+        if (bitsCount == 0) {
+            bits = (*this)();
+            bitsCount = 64;
+        }
+
+        bool value = bits & 1;
+        bits >>= 1;
+        bitsCount--;
+        return value;
+    }
+
+    static uint64_t mix(uint64_t value) {
+        value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+        return value ^ (value >> 31);
+    }
+};
@@ -0,0 +1,93 @@
+#include "reducer_options.h"
+
+void addArguments(ArgParser &parser) {
+    parser.add("-i", ArgType::String, "PATH", "path to init scheme", "");
+    parser.add("-o", ArgType::String, "PATH", "path to save schemes", "schemes");
+    parser.add("--count", ArgType::Natural, "INT", "number of reducers", "8");
+    parser.add("--part-initialization-rate", ArgType::Real, "REAL", "probability of partial fresh variable initialization from best solution", "0.3");
+    parser.add("--start-additions", ArgType::Natural, "INT", "upper bound of additions for check optimality", "0");
+    parser.add("--max-no-improvements", ArgType::Natural, "INT", "max iterations without improvements", "3");
+    parser.add("--max-time", ArgType::Real, "REAL", "time limit of the reduction in seconds, checked after every iteration (0 - unlimited)", "0");
+    parser.add("--profile", ArgType::String, "PATH", "tuning profile, options of the class of the input scheme are used unless given explicitly (none - disabled)", "none");
+    parser.add("--local-search-steps", ArgType::Natural, "INT", "steps of local search around the best scheme after iterations without improvements (0 - disabled)", "0");
+    parser.add("--crossover-rate", ArgType::Real, "REAL", "probability of building reducer by crossover of two elite solutions", "0");
+    parser.add("--elite-count", ArgType::Natural, "INT", "number of elite solutions kept for crossover per component", "32");
+    parser.add("--fork-count", ArgType::Natural, "INT", "number of reducers continuing one shared trunk of eliminations (0 - independent reducers)", "0");
+    parser.add("--fork-depth", ArgType::Real, "REAL", "trunk length relative to fresh variables of the best scheme, trunk forks at the next tie of most frequent pairs", "0.5");
+    parser.add("--orbit-variants", ArgType::Natural, "INT", "number of equivalent schemes generated by ternary basis changes and screened before reduction (0 - disabled)", "0");
+    parser.add("--orbit-depth", ArgType::Natural, "INT", "number of elementary basis changes of every generated variant", "4");
+    parser.add("--orbit-count", ArgType::Natural, "INT", "number of reducers screening every variant", "16");
+    parser.add("--orbit-iterations", ArgType::Natural, "INT", "max iterations without improvements of screening", "1");
+    parser.add("--orbit-promote", ArgType::Natural, "INT", "number of best screened variants reduced with all reducers", "1");
+    parser.add("--exact-max-nodes", ArgType::Natural, "INT", "node limit of exact branch and bound search per component after first iteration (0 - disabled)", "0");
+    parser.add("--duplicates", ArgType::Natural, "0/1", "collapse duplicate and negated rows of components before reduction", "0");
+    parser.add("--row-storage", ArgType::String, "MODE", "storage of rows for pair counting: dense (bitsets), sparse (sorted vectors) or auto (by density of every component)", "dense");
+    parser.add("--compact", ArgType::Natural, "0/1", "keep finished reducers as packed sequences and reduce in one working reducer per thread", "0");
+    parser.add("--symmetry", ArgType::Natural, "0/1", "detect components which are permutations of each other and reduce them once", "0");
+    parser.add("--generate-code", ArgType::Natural, "0/1", "save C++ block multiplication code next to every saved scheme", "0");
+    parser.add("--live-weight", ArgType::Real, "REAL", "weight of peak live temporaries in the score of reducers", "0");
+    parser.add("--traffic-weight", ArgType::Real, "REAL", "weight of memory traffic (block reads and writes) in the score of reducers", "0");
+    parser.add("--verify-saves", ArgType::Natural, "0/1", "verify every reduced scheme before saving", "1");
+    parser.add("--reduced", ArgType::String, "PATH", "path to reduced scheme checked in verify mode", "reduced.json");
+    parser.add("--reducer-tasks", ArgType::Natural, "INT", "number of tasks splitting pair counting and gi / gp scoring of one reducer", "1");
+    parser.add("--top-count", ArgType::Natural, "INT", "number of reducers for reporting", "10");
+    parser.add("--seed", ArgType::Natural, "INT", "random seed", "0");
+    parser.add("--ga-weight", ArgType::Real, "REAL", "weight of greedy alternative strategy", "0.25");
+    parser.add("--gr-weight", ArgType::Real, "REAL", "weight of greedy random strategy", "0.1");
+    parser.add("--wr-weight", ArgType::Real, "REAL", "weight of weighted random strategy", "0.1");
+    parser.add("--gi-weight", ArgType::Real, "REAL", "weight of greedy intersections strategy", "0.5");
+    parser.add("--gp-weight", ArgType::Real, "REAL", "weight of greedy potential strategy", "0.0");
+    parser.add("--bs-weight", ArgType::Real, "REAL", "weight of beam search strategy", "0.0");
+    parser.add("--mix-weight", ArgType::Real, "REAL", "weight of mixed strategy", "0.05");
+    parser.add("--beam-width", ArgType::Natural, "INT", "number of states kept by beam search strategy", "4");
+    parser.add("--numa", ArgType::Natural, "INT", "replicate init and best schemes on every NUMA node (0 - disabled, 1 - enabled)", "1");
+    parser.add("--pin-threads", ArgType::Natural, "INT", "pin threads to cpus grouped by NUMA nodes (0 - disabled, 1 - enabled)", "0");
+    parser.add("--mode", ArgType::String, "MODE", "run mode: reduce, worker, coordinator, verify or server", "reduce");
+    parser.add("--socket", ArgType::String, "PATH", "unix socket of the server accepting jobs (- - jobs are read from stdin one by one)", "ternary_addition_reducer.sock");
+    parser.add("--server-jobs", ArgType::Natural, "INT", "number of jobs run concurrently by the server, threads are shared equally", "1");
+    parser.add("--exchange-path", ArgType::String, "PATH", "shared directory for exchanging best results between workers and coordinator", "exchange");
+    parser.add("--exchange-interval", ArgType::Real, "REAL", "iterations between exchanges for worker / seconds between polls for coordinator", "1");
+    parser.add("--worker-id", ArgType::String, "NAME", "unique worker name without spaces (default: hostname and pid)", "auto");
+    parser.add("--coordinator-timeout", ArgType::Real, "REAL", "seconds without improvements from workers before coordinator stops", "600");
+}
+
+StrategyWeights getStrategyWeights(const ArgParser &parser) {
+    StrategyWeights strategyWeights;
+    strategyWeights.greedyAlternative = std::stod(parser.get("--ga-weight"));
+    strategyWeights.greedyRandom = std::stod(parser.get("--gr-weight"));
+    strategyWeights.weightedRandom = std::stod(parser.get("--wr-weight"));
+    strategyWeights.greedyIntersections = std::stod(parser.get("--gi-weight"));
+    strategyWeights.greedyPotential = std::stod(parser.get("--gp-weight"));
+    strategyWeights.beamSearch = std::stod(parser.get("--bs-weight"));
+    strategyWeights.mix = std::stod(parser.get("--mix-weight"));
+    strategyWeights.beamWidth = std::stoi(parser.get("--beam-width"));
+    return strategyWeights;
+}
+
+RowStorage getRowStorage(const std::string &name) {
+    if (name == "dense")
+        return RowStorage::Dense;
+
+    if (name == "sparse")
+        return RowStorage::Sparse;
+
+    return RowStorage::Auto;
+}
+
+void prepareReducer(const ArgParser &parser, SchemeReducer &reducer) {
+    reducer.setSymmetry(std::stoi(parser.get("--symmetry")));
+    reducer.setDuplicates(std::stoi(parser.get("--duplicates")));
+    reducer.setRowStorage(getRowStorage(parser.get("--row-storage")));
+    reducer.setCompact(std::stoi(parser.get("--compact")));
+    reducer.setCodeGeneration(std::stoi(parser.get("--generate-code")));
+}
+
+void configureReducer(const ArgParser &parser, SchemeReducer &reducer) {
+    reducer.setLocalSearch(std::stoi(parser.get("--local-search-steps")));
+    reducer.setCrossover(std::stod(parser.get("--crossover-rate")), std::stoi(parser.get("--elite-count")));
+    reducer.setFork(std::stoi(parser.get("--fork-count")), std::stod(parser.get("--fork-depth")));
+    reducer.setExact(std::stol(parser.get("--exact-max-nodes")));
+    reducer.setMemoryModel(std::stod(parser.get("--live-weight")), std::stod(parser.get("--traffic-weight")));
+    reducer.setReducerTasks(std::stoi(parser.get("--reducer-tasks")));
+    reducer.setMaxTime(std::stod(parser.get("--max-time")));
+}
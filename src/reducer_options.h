@@ -0,0 +1,17 @@
+#pragma once
+
+#include <string>
+
+#include "arg_parser.h"
+#include "scheme_reducer.h"
+
+// command line options of the reducer, shared by the reducer, jobs of the server and the tuning tool, so all of them use the same defaults
+void addArguments(ArgParser &parser);
+StrategyWeights getStrategyWeights(const ArgParser &parser);
+RowStorage getRowStorage(const std::string &name);
+
+// options read by initialization of the scheme
+void prepareReducer(const ArgParser &parser, SchemeReducer &reducer);
+
+// options of the reduction
+void configureReducer(const ArgParser &parser, SchemeReducer &reducer);
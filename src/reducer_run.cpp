@@ -0,0 +1,333 @@
+#include "reducer_run.h"
+
+#include <fstream>
+#include <sstream>
+#include <ctime>
+#include <climits>
+#include <numeric>
+#include <unistd.h>
+
+#include "scheme_reducer.h"
+#include "scheme_orbit.h"
+#include "tuning_profile.h"
+#include "reducer_options.h"
+
+bool readScheme(const std::string &path, std::istream &input, std::string &text) {
+    std::stringstream ss;
+
+    if (path == "-") {
+        int n1 = 0, n2 = 0, n3 = 0, rank = 0;
+        if (!(input >> n1 >> n2 >> n3 >> rank))
+            return false;
+
+        ss << n1 << " " << n2 << " " << n3 << " " << rank << std::endl;
+        int coefficients = rank * (n1 * n2 + n2 * n3 + n3 * n1);
+
+        for (int i = 0; i < coefficients; i++) {
+            int value;
+            if (!(input >> value))
+                return false;
+
+            ss << value << (i + 1 < coefficients ? " " : "\n");
+        }
+    }
+    else {
+        std::ifstream f(path);
+        if (!f)
+            return false;
+
+        ss << f.rdbuf();
+    }
+
+    text = ss.str();
+    return true;
+}
+
+int runReducer(ArgParser &parser, std::istream &input, std::ostream &os) {
+    std::string schemeText;
+    bool readed = readScheme(parser.get("-i"), input, schemeText);
+
+    std::string profilePath = parser.get("--profile");
+    std::string profileClass;
+
+    if (profilePath != "none") {
+        TuningProfile profile;
+        ProfileOptions options;
+        int n1 = 0, n2 = 0, n3 = 0, rank = 0;
+
+        std::stringstream input(schemeText);
+        input >> n1 >> n2 >> n3 >> rank;
+
+        if (!profile.read(profilePath)) {
+            os << "Unable to read tuning profile \"" << profilePath << "\"" << std::endl;
+            return -1;
+        }
+
+        profileClass = TuningProfile::getClass(rank);
+
+        if (profile.get(profileClass, options)) {
+            for (const auto &option : options)
+                if (!parser.isGiven(option.first) && !parser.set(option.first, option.second))
+                    return -1;
+        }
+        else {
+            profileClass += " (not tuned)";
+        }
+    }
+
+    std::string inputPath = parser.get("-i");
+    std::string outputPath = parser.get("-o");
+
+    int count = std::stoi(parser.get("--count"));
+    double partialInitializationRate = std::stod(parser.get("--part-initialization-rate"));
+    int startAdditions = std::stoi(parser.get("--start-additions"));
+    int maxNoImprovements = std::stoi(parser.get("--max-no-improvements"));
+    double maxTime = std::stod(parser.get("--max-time"));
+    int localSearchSteps = std::stoi(parser.get("--local-search-steps"));
+    double crossoverRate = std::stod(parser.get("--crossover-rate"));
+    int forkCount = std::stoi(parser.get("--fork-count"));
+    double forkDepth = std::stod(parser.get("--fork-depth"));
+    int eliteCount = std::stoi(parser.get("--elite-count"));
+    int orbitVariants = std::stoi(parser.get("--orbit-variants"));
+    int orbitDepth = std::stoi(parser.get("--orbit-depth"));
+    int orbitCount = std::stoi(parser.get("--orbit-count"));
+    int orbitIterations = std::stoi(parser.get("--orbit-iterations"));
+    int orbitPromote = std::stoi(parser.get("--orbit-promote"));
+    long exactMaxNodes = std::stol(parser.get("--exact-max-nodes"));
+    bool symmetry = std::stoi(parser.get("--symmetry"));
+    bool duplicates = std::stoi(parser.get("--duplicates"));
+    std::string rowStorageName = parser.get("--row-storage");
+    bool compact = std::stoi(parser.get("--compact"));
+    bool generateCode = std::stoi(parser.get("--generate-code"));
+    double liveWeight = std::stod(parser.get("--live-weight"));
+    double trafficWeight = std::stod(parser.get("--traffic-weight"));
+    bool verifySaves = std::stoi(parser.get("--verify-saves"));
+    std::string reducedPath = parser.get("--reduced");
+    int reducerTasks = std::stoi(parser.get("--reducer-tasks"));
+    int topCount = std::stoi(parser.get("--top-count"));
+    int seed = std::stoi(parser.get("--seed"));
+
+    bool numa = std::stoi(parser.get("--numa")) == 1;
+    bool pinThreads = std::stoi(parser.get("--pin-threads")) == 1;
+
+    std::string mode = parser.get("--mode");
+    std::string exchangePath = parser.get("--exchange-path");
+    double exchangeInterval = std::stod(parser.get("--exchange-interval"));
+    std::string workerId = parser.get("--worker-id");
+    double coordinatorTimeout = std::stod(parser.get("--coordinator-timeout"));
+
+    StrategyWeights strategyWeights = getStrategyWeights(parser);
+
+    if (strategyWeights.getTotal() <= 0) {
+        os << "Strategy weights are invalid (sum <= 0)" << std::endl;
+        return -1;
+    }
+
+    if (rowStorageName != "auto" && rowStorageName != "dense" && rowStorageName != "sparse") {
+        os << "Unknown row storage \"" << rowStorageName << "\"" << std::endl;
+        return -1;
+    }
+
+    if (mode != "reduce" && mode != "worker" && mode != "coordinator" && mode != "verify") {
+        os << "Unknown mode \"" << mode << "\"" << std::endl;
+        return -1;
+    }
+
+    if (seed == 0)
+        seed = time(0);
+
+    if (workerId == "auto") {
+        char hostname[256] = "";
+        gethostname(hostname, sizeof(hostname) - 1);
+        workerId = std::string(hostname) + "-" + std::to_string(getpid());
+    }
+
+    os << "Start additions reduction algorithm with parameters:" << std::endl;
+    os << "- count: " << count << std::endl;
+    os << "- input path: " << inputPath << std::endl;
+    os << "- output path: " << outputPath << std::endl;
+    os << "- partial initialization rate: " << partialInitializationRate << std::endl;
+
+    if (startAdditions > 0)
+        os << "- start additions: " << startAdditions << std::endl;
+
+    os << "- max no improvements: " << maxNoImprovements << std::endl;
+
+    if (maxTime > 0)
+        os << "- max time: " << maxTime << std::endl;
+
+    if (profilePath != "none")
+        os << "- profile: " << profilePath << " (class: " << profileClass << ")" << std::endl;
+
+    if (localSearchSteps > 0)
+        os << "- local search steps: " << localSearchSteps << std::endl;
+
+    if (exactMaxNodes > 0)
+        os << "- exact max nodes: " << exactMaxNodes << std::endl;
+
+    if (crossoverRate > 0)
+        os << "- crossover rate: " << crossoverRate << " (elite count: " << eliteCount << ")" << std::endl;
+
+    if (forkCount > 1)
+        os << "- fork count: " << forkCount << " (depth: " << forkDepth << ")" << std::endl;
+
+    if (orbitVariants > 0)
+        os << "- orbit variants: " << orbitVariants << " (depth: " << orbitDepth << ", count: " << orbitCount << ", iterations: " << orbitIterations << ", promote: " << orbitPromote << ")" << std::endl;
+
+    os << "- top count: " << topCount << std::endl;
+    os << "- seed: " << seed << std::endl;
+    os << "- numa replicas: " << (numa ? "yes" : "no") << std::endl;
+    os << "- pin threads: " << (pinThreads ? "yes" : "no") << std::endl;
+    os << "- symmetry: " << (symmetry ? "yes" : "no") << std::endl;
+    os << "- duplicates: " << (duplicates ? "collapse" : "keep") << std::endl;
+    os << "- row storage: " << rowStorageName << std::endl;
+    os << "- compact reducers: " << (compact ? "yes" : "no") << std::endl;
+    os << "- generate code: " << (generateCode ? "yes" : "no") << std::endl;
+    os << "- verify saves: " << (verifySaves ? "yes" : "no") << std::endl;
+
+    if (reducerTasks > 1)
+        os << "- reducer tasks: " << reducerTasks << std::endl;
+
+    if (liveWeight > 0 || trafficWeight > 0)
+        os << "- memory model weights (live / traffic): " << liveWeight << " / " << trafficWeight << std::endl;
+
+    if (mode == "verify") {
+        os << "- mode: " << mode << std::endl;
+        os << "- reduced path: " << reducedPath << std::endl;
+    }
+    else if (mode != "reduce") {
+        os << "- mode: " << mode << std::endl;
+        os << "- exchange path: " << exchangePath << std::endl;
+        os << "- exchange interval: " << exchangeInterval << std::endl;
+    }
+
+    if (mode == "worker")
+        os << "- worker id: " << workerId << std::endl;
+
+    os << std::endl;
+
+    os << "Strategy selection weights:" << std::endl;
+    os << "- greedy intersections: " << strategyWeights.greedyIntersections << std::endl;
+    os << "- greedy alternative: " << strategyWeights.greedyAlternative << std::endl;
+    os << "- greedy random: " << strategyWeights.greedyRandom << std::endl;
+    os << "- weighted random: " << strategyWeights.weightedRandom << std::endl;
+    os << "- greedy potential: " << strategyWeights.greedyPotential << std::endl;
+    os << "- beam search: " << strategyWeights.beamSearch << " (width: " << strategyWeights.beamWidth << ")" << std::endl;
+    os << "- mix: " << strategyWeights.mix << std::endl;
+    os << std::endl;
+
+    if (!readed) {
+        os << "Unable to open file \"" << inputPath << "\"" << std::endl;
+        return -1;
+    }
+
+    SchemeReducer reducer(count, outputPath, strategyWeights, seed);
+    reducer.setOutput(os);
+
+    if (!reducer.setNuma(numa, pinThreads))
+        return -1;
+
+    prepareReducer(parser, reducer);
+
+    std::stringstream f(schemeText);
+    if (!reducer.initialize(f))
+        return -1;
+
+    DirectoryExchange exchange(exchangePath);
+
+    if (mode == "verify") {
+        std::ifstream reduced(reducedPath);
+        if (!reduced) {
+            os << "Unable to open file \"" << reducedPath << "\"" << std::endl;
+            return -1;
+        }
+
+        return reducer.verify(reduced) ? 0 : -1;
+    }
+
+    reducer.setVerification(verifySaves);
+
+    if (mode == "coordinator") {
+        reducer.coordinate(exchange, exchangeInterval, coordinatorTimeout, startAdditions);
+        return 0;
+    }
+
+    configureReducer(parser, reducer);
+
+    if (mode == "worker")
+        reducer.setExchange(&exchange, workerId, int(exchangeInterval));
+
+    if (mode == "reduce" && orbitVariants > 0) {
+        std::stringstream input(schemeText);
+        SchemeOrbit orbit(orbitDepth);
+        orbit.read(input);
+
+        // reducer tasks use streams of phases 0 - 2
+        RandomGenerator generator(seed, (uint64_t) 3 << 56);
+        int variants = orbit.generate(orbitVariants, generator, os);
+        std::vector<std::pair<int, int>> costs(variants + 1, {INT_MAX, INT_MAX});
+
+        os << "Orbit of the scheme: " << variants << " equivalent variants found" << std::endl << std::endl;
+
+        // variants are screened one by one with a small budget, every screening uses all threads
+        for (int i = 0; i <= variants; i++) {
+            os << "Screening orbit variant " << i << " / " << variants << ": ";
+            SchemeReducer variantReducer(orbitCount, outputPath, strategyWeights, seed);
+            variantReducer.setOutput(os);
+            variantReducer.setNuma(numa, false);
+            variantReducer.setSaving(false);
+            prepareReducer(parser, variantReducer);
+
+            if (!variantReducer.initialize(orbit.getVariants()[i]))
+                continue;
+
+            configureReducer(parser, variantReducer);
+            variantReducer.reduce(orbitIterations, 0, partialInitializationRate, std::min(topCount, orbitCount));
+            costs[i] = {variantReducer.getReducedAdditions(), variantReducer.getReducedFreshVars()};
+        }
+
+        std::vector<int> order(costs.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [&costs](int index1, int index2) {
+            return costs[index1] < costs[index2];
+        });
+
+        os << "Orbit screening (variant: additions / fresh vars):";
+        for (int i : order)
+            os << " " << i << ": " << costs[i].first << " / " << costs[i].second << ";";
+        os << std::endl << std::endl;
+
+        for (int i = 0; i < orbitPromote && i < (int) order.size(); i++) {
+            int variant = order[i];
+            os << "Promoted orbit variant " << variant << " (screened additions: " << costs[variant].first << ")" << std::endl;
+
+            if (variant == 0) {
+                reducer.reduce(maxNoImprovements, startAdditions, partialInitializationRate, topCount);
+                continue;
+            }
+
+            // reduced schemes of a variant are verified against the variant, so it is saved next to them
+            const Scheme &scheme = orbit.getVariants()[variant];
+            std::string schemePath = outputPath + "/" + std::to_string(scheme.dimension[0]) + "x" + std::to_string(scheme.dimension[1]) + "x" + std::to_string(scheme.dimension[2]) + "_m" + std::to_string(scheme.rank) + "_v" + std::to_string(variant) + ".txt";
+            std::ofstream output(schemePath);
+            scheme.write(output);
+            output.close();
+            os << "Orbit variant " << variant << " saved to \"" << schemePath << "\"" << std::endl << std::endl;
+
+            SchemeReducer variantReducer(count, outputPath, strategyWeights, seed);
+            variantReducer.setOutput(os);
+            variantReducer.setNuma(numa, false);
+            variantReducer.setSaving(true, variant);
+            prepareReducer(parser, variantReducer);
+            variantReducer.initialize(scheme);
+            configureReducer(parser, variantReducer);
+            variantReducer.setVerification(verifySaves);
+            variantReducer.reduce(maxNoImprovements, startAdditions, partialInitializationRate, topCount);
+        }
+
+        return 0;
+    }
+
+    reducer.reduce(maxNoImprovements, startAdditions, partialInitializationRate, topCount);
+    return 0;
+}
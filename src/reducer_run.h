@@ -0,0 +1,12 @@
+#pragma once
+
+#include <iostream>
+#include <string>
+
+#include "arg_parser.h"
+
+// reads the scheme once, "-" reads it from the input stream of the job: dimensions, rank and then all coefficients
+bool readScheme(const std::string &path, std::istream &input, std::string &text);
+
+// one run of the reducer with parsed options (reduce, worker, coordinator or verify mode), used by the command line, jobs of the server and tests
+int runReducer(ArgParser &parser, std::istream &input, std::ostream &os);
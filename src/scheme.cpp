@@ -34,6 +34,14 @@ bool Scheme::read(std::istream &is, bool check) {
     return !check || validate();
 }
 
+void Scheme::write(std::ostream &os) const {
+    os << dimension[0] << " " << dimension[1] << " " << dimension[2] << " " << rank << std::endl;
+
+    for (int i = 0; i < 3; i++)
+        for (size_t j = 0; j < uvw[i].size(); j++)
+            os << uvw[i][j] << (j == uvw[i].size() - 1 ? "\n" : " ");
+}
+
 bool Scheme::validateEquation(int i, int j, int k) const {
     int i1 = i / dimension[1];
     int i2 = i % dimension[1];
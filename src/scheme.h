@@ -13,6 +13,7 @@ struct Scheme {
 
     bool validate() const;
     bool read(std::istream &is, bool check = true);
+    void write(std::ostream &os) const;
 private:
     bool validateEquation(int i, int j, int k) const;
 };
@@ -0,0 +1,132 @@
+#include "scheme_orbit.h"
+
+SchemeOrbit::SchemeOrbit(int depth) {
+    this->depth = depth;
+}
+
+bool SchemeOrbit::read(std::istream &is) {
+    int n1, n2, n3, rank;
+    is >> n1 >> n2 >> n3 >> rank;
+
+    Scheme scheme(n1, n2, n3, rank);
+    if (!scheme.read(is))
+        return false;
+
+    variants.clear();
+    forms.clear();
+    variants.push_back(scheme);
+    forms.insert(getCanonicalForm(scheme));
+    return true;
+}
+
+int SchemeOrbit::generate(int count, RandomGenerator &generator, std::ostream &os) {
+    const Scheme &input = variants[0];
+    std::vector<int> sides;
+
+    for (int side = 0; side < 3; side++)
+        if (input.dimension[side] > 1)
+            sides.push_back(side);
+
+    if (sides.empty())
+        return 0;
+
+    std::uniform_int_distribution<int> sideDistribution(0, sides.size() - 1);
+
+    // every walk starts from a found variant, so the orbit is explored farther than depth steps from the input,
+    // walks ending in a known variant (up to order and signs of products) are retried a limited number of times
+    for (int attempt = 0; attempt < count * 16 && (int) variants.size() <= count; attempt++) {
+        std::uniform_int_distribution<int> variantDistribution(0, variants.size() - 1);
+        Scheme scheme = variants[variantDistribution(generator)];
+
+        for (int step = 0; step < depth; step++) {
+            for (int trial = 0; trial < 32; trial++) {
+                int side = sides[sideDistribution(generator)];
+                std::uniform_int_distribution<int> rowDistribution(0, scheme.dimension[side] - 1);
+                int row1 = rowDistribution(generator);
+                int row2 = rowDistribution(generator);
+
+                if (row1 == row2)
+                    continue;
+
+                Scheme candidate = scheme;
+                if (!changeBasis(candidate, side, row1, row2, generator.bit() ? 1 : -1))
+                    continue;
+
+                scheme = candidate;
+                break;
+            }
+        }
+
+        if (!scheme.validate()) {
+            os << "Skip orbit variant: basis change breaks Brent equations" << std::endl;
+            continue;
+        }
+
+        if (forms.insert(getCanonicalForm(scheme)).second)
+            variants.push_back(scheme);
+    }
+
+    return variants.size() - 1;
+}
+
+const std::vector<Scheme>& SchemeOrbit::getVariants() const {
+    return variants;
+}
+
+bool SchemeOrbit::changeBasis(Scheme &scheme, int side, int row1, int row2, int sign) const {
+    // P = I + sign * E(row1, row2) adds a row of matrices of one component and subtracts a column of the previous one:
+    // U, V, W rows are indexed by n1, n2, n3 and their columns by n2, n3, n1
+    int rowComponent = side;
+    int columnComponent = (side + 2) % 3;
+    int rows = scheme.dimension[columnComponent];
+    int columns = scheme.dimension[(rowComponent + 1) % 3];
+
+    for (int index = 0; index < scheme.rank; index++) {
+        int *matrix = scheme.uvw[rowComponent].data() + index * scheme.elements[rowComponent];
+
+        for (int column = 0; column < columns; column++) {
+            int &value = matrix[row1 * columns + column];
+            value += sign * matrix[row2 * columns + column];
+
+            if (abs(value) > 1)
+                return false;
+        }
+
+        matrix = scheme.uvw[columnComponent].data() + index * scheme.elements[columnComponent];
+
+        for (int row = 0; row < rows; row++) {
+            int &value = matrix[row * scheme.dimension[side] + row2];
+            value -= sign * matrix[row * scheme.dimension[side] + row1];
+
+            if (abs(value) > 1)
+                return false;
+        }
+    }
+
+    return true;
+}
+
+std::vector<int> SchemeOrbit::getCanonicalForm(const Scheme &scheme) const {
+    std::vector<std::vector<int>> products(scheme.rank);
+
+    // order of products and signs of their factors do not change additions, the first nonzero coefficient of every factor is positive
+    for (int index = 0; index < scheme.rank; index++) {
+        for (int i = 0; i < 3; i++) {
+            auto begin = scheme.uvw[i].begin() + index * scheme.elements[i];
+            auto end = begin + scheme.elements[i];
+            auto first = std::find_if(begin, end, [](int value) { return value != 0; });
+            int sign = first != end && *first < 0 ? -1 : 1;
+
+            for (auto it = begin; it != end; it++)
+                products[index].push_back(*it * sign);
+        }
+    }
+
+    std::sort(products.begin(), products.end());
+
+    std::vector<int> form;
+    for (const auto &product : products)
+        form.insert(form.end(), product.begin(), product.end());
+
+    return form;
+}
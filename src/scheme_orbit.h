@@ -0,0 +1,28 @@
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <set>
+#include <random>
+#include <algorithm>
+#include <cstdlib>
+
+#include "scheme.h"
+#include "random_generator.h"
+
+// equivalent schemes of the input scheme: basis changes A -> P A Q^-1, B -> Q B R^-1, C -> R C P^-1 keep the product,
+// elementary P = I + sE (inverse I - sE) are applied while all coefficients stay ternary
+class SchemeOrbit {
+    int depth;
+    std::vector<Scheme> variants;
+    std::set<std::vector<int>> forms;
+public:
+    SchemeOrbit(int depth);
+
+    bool read(std::istream &is);
+    int generate(int count, RandomGenerator &generator, std::ostream &os);
+    const std::vector<Scheme>& getVariants() const;
+private:
+    bool changeBasis(Scheme &scheme, int side, int row1, int row2, int sign) const;
+    std::vector<int> getCanonicalForm(const Scheme &scheme) const;
+};
@@ -2,38 +2,98 @@
 
 SchemeReducer::SchemeReducer(int count, const std::string path, const StrategyWeights &strategyWeights, int seed) : uniformDistribution(0.0, 1.0) {
     this->count = count;
+    this->seed = seed;
     this->path = path;
+    this->output = &std::cout;
+    this->variant = 0;
+    this->saving = true;
+    this->maxTime = 0;
+    this->improvementTime = 0;
     this->strategyWeights = strategyWeights;
+    this->exchange = nullptr;
+    this->exchangeInterval = 1;
+    this->numaReplicas = false;
+    this->localSearchSteps = 0;
+    this->crossoverRate = 0;
+    this->eliteCount = 0;
+    this->exactMaxNodes = 0;
+    this->symmetry = false;
+    this->duplicates = false;
+    this->rowStorage = RowStorage::Dense;
+    this->compact = false;
+    this->generateCode = false;
+    this->verifySaves = false;
+    this->reducerTasks = 1;
+    this->forkCount = 0;
+    this->forkDepth = 0;
+    this->liveWeight = 0;
+    this->trafficWeight = 0;
 
     for (int i = 0; i < 3; i++) {
+        mirror[i] = -1;
         uvw[i] = std::vector<AdditionReducer>(count);
+        records[i] = std::vector<ReducerRecord>(count);
+        scores[i] = std::vector<double>(count, 0);
         indices[i].reserve(count);
 
         for (int j = 0; j < count; j++)
             indices[i].push_back(j);
     }
-
-    int maxThreads = omp_get_max_threads();
-    for (int i = 0; i < maxThreads; i++)
-        generators.emplace_back(seed + i);
 }
 
 bool SchemeReducer::initialize(std::istream &is) {
     is >> dimension[0] >> dimension[1] >> dimension[2] >> rank;
-    std::cout << "Reading scheme " << dimension[0] << "x" << dimension[1] << "x" << dimension[2] << " with " << rank << " multiplications: ";
+    *output << "Reading scheme " << dimension[0] << "x" << dimension[1] << "x" << dimension[2] << " with " << rank << " multiplications: ";
 
     Scheme scheme(dimension[0], dimension[1], dimension[2], rank);
     if (!scheme.read(is)) {
-        std::cout << "error, readed scheme is invalid" << std::endl;
+        *output << "error, readed scheme is invalid" << std::endl;
         return false;
     }
 
+    return initialize(scheme);
+}
+
+bool SchemeReducer::initialize(const Scheme &scheme) {
+    for (int i = 0; i < 3; i++)
+        dimension[i] = scheme.dimension[i];
+
+    rank = scheme.rank;
+
+    for (int i = 0; i < 3; i++)
+        init[i].setRowStorage(rowStorage);
+
     if (!parseScheme(scheme)) {
-        std::cout << "error, readed scheme has non ternary coefficients" << std::endl;
+        *output << "error, readed scheme has non ternary coefficients" << std::endl;
         return false;
     }
 
-    std::cout << "success" << std::endl << std::endl;
+    *output << "success" << std::endl << std::endl;
+
+    if (init[0].isSparse() || init[1].isSparse() || init[2].isSparse()) {
+        *output << "Row storage (U / V / W): ";
+        *output << (init[0].isSparse() ? "sparse" : "dense") << " / " << (init[1].isSparse() ? "sparse" : "dense") << " / " << (init[2].isSparse() ? "sparse" : "dense") << std::endl << std::endl;
+    }
+
+    if (duplicates) {
+        int rows[3];
+
+        for (int i = 0; i < 3; i++)
+            rows[i] = init[i].collapseDuplicates();
+
+        if (rows[0] + rows[1] + rows[2] > 0) {
+            *output << "Duplicate rows (U / V / W): " << rows[0] << " / " << rows[1] << " / " << rows[2] << ", they are not counted by strategies and reuse their first occurrence";
+            *output << " (naive additions of duplicates: " << init[0].getDuplicateAdditions() << " / " << init[1].getDuplicateAdditions() << " / " << init[2].getDuplicateAdditions() << ")" << std::endl << std::endl;
+        }
+    }
+
+    if (compact && !PackedSequence::canPack(std::max({init[0].getMaxVariable(), init[1].getMaxVariable(), init[2].getMaxVariable()}))) {
+        *output << "Fresh variables of this scheme can not be packed, compact storage of reducers is disabled" << std::endl << std::endl;
+        setCompact(false);
+    }
+
+    if (symmetry)
+        detectSymmetry();
 
     #pragma omp parallel for
     for (int i = 0; i < 3; i++) {
@@ -41,17 +101,23 @@ bool SchemeReducer::initialize(std::istream &is) {
         bestAdditions[i] = init[i].getNaiveAdditions();
         bestStrategies[i] = init[i].getStrategy();
         bestFreshVars[i] = 0;
+        publishedAdditions[i] = bestAdditions[i];
+        publishedFreshVars[i] = 0;
+        optimal[i] = false;
     }
 
+    if (numaReplicas)
+        replicate(init, localInit);
+
     naiveAdditions = bestAdditions[0] + bestAdditions[1] + bestAdditions[2];
     reducedAdditions = naiveAdditions;
     reducedFreshVars = 0;
 
-    std::cout << "Readed scheme params:" << std::endl;
-    std::cout << "- dimensions: " << dimension[0] << "x" << dimension[1] << "x" << dimension[2] << std::endl;
-    std::cout << "- multiplications (rank): " << rank << std::endl;
-    std::cout << "- naive additions (U / V / W / total): " << bestAdditions[0] << " / " << bestAdditions[1] << " / " << bestAdditions[2] << " / " << reducedAdditions << std::endl;
-    std::cout << std::endl;
+    *output << "Readed scheme params:" << std::endl;
+    *output << "- dimensions: " << dimension[0] << "x" << dimension[1] << "x" << dimension[2] << std::endl;
+    *output << "- multiplications (rank): " << rank << std::endl;
+    *output << "- naive additions (U / V / W / total): " << bestAdditions[0] << " / " << bestAdditions[1] << " / " << bestAdditions[2] << " / " << reducedAdditions << std::endl;
+    *output << std::endl;
     return true;
 }
 
@@ -66,21 +132,223 @@ void SchemeReducer::reduce(int maxNoImprovements, int startAdditions, double par
         auto t1 = std::chrono::high_resolution_clock::now();
         reduceIteration(iteration, partialInitializationRate);
         bool improved = update(startAdditions, topCount);
+
+        // most full iterations fail to improve near the end of the run, so try cheaper local moves around the best
+        if (!improved && localSearchSteps > 0) {
+            localSearchIteration(iteration);
+            improved = update(startAdditions, topCount);
+        }
+
+        if (exchange && iteration % exchangeInterval == 0 && exchangeBest(startAdditions))
+            improved = true;
+
+        if (iteration == 1 && exactMaxNodes > 0)
+            solveExact(startAdditions);
+
         auto t2 = std::chrono::high_resolution_clock::now();
 
         elapsedTimes.push_back(std::chrono::duration_cast<std::chrono::milliseconds>(t2 - t1).count() / 1000.0);
         report(startTime, iteration, elapsedTimes, topCount);
 
+        if (optimal[0] && optimal[1] && optimal[2]) {
+            *output << "All components are proven optimal" << std::endl;
+            break;
+        }
+
+        double elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(t2 - startTime).count() / 1000.0;
+        if (improved)
+            improvementTime = elapsed;
+
+        if (maxTime > 0 && elapsed >= maxTime) {
+            *output << "Time limit of " << prettyTime(maxTime) << " is reached" << std::endl;
+            break;
+        }
+
         if (improved) {
             noImprovements = 0;
         }
         else {
             noImprovements++;
-            std::cout << "No improvements for " << noImprovements << " / " << maxNoImprovements << " iterations" << std::endl;
+            *output << "No improvements for " << noImprovements << " / " << maxNoImprovements << " iterations" << std::endl;
         }
     }
 }
 
+bool SchemeReducer::setNuma(bool replicas, bool pinThreads) {
+    numaReplicas = replicas && topology.getNodes() > 1;
+
+    if (pinThreads && !topology.pinThreads()) {
+        *output << "Unable to pin threads to cpus" << std::endl;
+        return false;
+    }
+
+    return true;
+}
+
+void SchemeReducer::setLocalSearch(int localSearchSteps) {
+    this->localSearchSteps = localSearchSteps;
+}
+
+void SchemeReducer::setCrossover(double crossoverRate, int eliteCount) {
+    this->crossoverRate = crossoverRate;
+    this->eliteCount = eliteCount;
+}
+
+void SchemeReducer::setExact(long exactMaxNodes) {
+    this->exactMaxNodes = exactMaxNodes;
+}
+
+void SchemeReducer::setSymmetry(bool symmetry) {
+    this->symmetry = symmetry;
+}
+
+void SchemeReducer::setDuplicates(bool duplicates) {
+    this->duplicates = duplicates;
+}
+
+void SchemeReducer::setRowStorage(RowStorage rowStorage) {
+    this->rowStorage = rowStorage;
+}
+
+void SchemeReducer::setCompact(bool compact) {
+    this->compact = compact;
+
+    // compact mode keeps one working reducer per thread instead of one per task
+    pool = std::vector<AdditionReducer>(compact ? omp_get_max_threads() : 0);
+
+    for (int i = 0; i < 3; i++)
+        uvw[i] = std::vector<AdditionReducer>(compact ? 0 : records[i].size());
+}
+
+void SchemeReducer::setCodeGeneration(bool generateCode) {
+    this->generateCode = generateCode;
+}
+
+void SchemeReducer::setMemoryModel(double liveWeight, double trafficWeight) {
+    this->liveWeight = liveWeight;
+    this->trafficWeight = trafficWeight;
+}
+
+void SchemeReducer::setVerification(bool verifySaves) {
+    this->verifySaves = verifySaves;
+}
+
+void SchemeReducer::setSaving(bool saving, int variant) {
+    this->saving = saving;
+    this->variant = variant;
+}
+
+void SchemeReducer::setMaxTime(double maxTime) {
+    this->maxTime = maxTime;
+}
+
+void SchemeReducer::setOutput(std::ostream &output) {
+    this->output = &output;
+}
+
+void SchemeReducer::setReducerTasks(int reducerTasks) {
+    this->reducerTasks = reducerTasks;
+}
+
+void SchemeReducer::setFork(int forkCount, double forkDepth) {
+    this->forkCount = forkCount;
+    this->forkDepth = forkDepth;
+
+    for (int i = 0; i < 3; i++)
+        trunks[i] = std::vector<AdditionReducer>(forkCount > 1 ? (count + forkCount - 1) / forkCount : 0);
+}
+
+void SchemeReducer::setExchange(BestExchange *exchange, const std::string &worker, int exchangeInterval) {
+    this->exchange = exchange;
+    this->worker = worker;
+    this->exchangeInterval = std::max(exchangeInterval, 1);
+}
+
+void SchemeReducer::coordinate(BestExchange &exchange, double interval, double timeout, int startAdditions) {
+    auto lastImprovement = std::chrono::high_resolution_clock::now();
+    *output << "Start coordinator for " << getDimension() << " scheme (poll interval: " << interval << " sec, timeout: " << timeout << " sec)" << std::endl;
+
+    while (true) {
+        bool improved = false;
+
+        for (int i = 0; i < 3; i++) {
+            bool componentImproved = false;
+
+            for (const auto &record : exchange.collect(getExchangeName(i), init[i].getNaiveAdditions()))
+                if (adoptRecord(i, record))
+                    componentImproved = true;
+
+            if (componentImproved && exchange.store(getExchangeName(i), {bestStrategies[i], bestAdditions[i], bestFreshVars[i], best[i].getFreshVariables()}))
+                improved = true;
+        }
+
+        auto now = std::chrono::high_resolution_clock::now();
+
+        if (improved) {
+            updateReduced(startAdditions);
+            *output << "- best additions (U / V / W / total): " << bestAdditions[0] << " / " << bestAdditions[1] << " / " << bestAdditions[2] << " / " << reducedAdditions << std::endl;
+            *output << "- best workers (U / V / W): " << bestStrategies[0] << " / " << bestStrategies[1] << " / " << bestStrategies[2] << std::endl;
+            lastImprovement = now;
+        }
+        else if (std::chrono::duration_cast<std::chrono::milliseconds>(now - lastImprovement).count() / 1000.0 >= timeout) {
+            break;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(int(interval * 1000)));
+    }
+
+    *output << "No improvements from workers for " << timeout << " seconds, coordinator stopped" << std::endl;
+}
+
+bool SchemeReducer::verify(std::istream &is) const {
+    std::vector<std::unordered_set<int>> rows[3] = {init[0].getExpressions().unpack(), init[1].getExpressions().unpack(), init[2].getExpressions().unpack()};
+    SchemeVerifier verifier(dimension, rank, rows);
+    ReducedComponent components[3];
+
+    if (!verifier.read(is, components)) {
+        *output << "Unable to read reduced scheme" << (verifier.getError().empty() ? "" : ": " + verifier.getError()) << std::endl;
+        return false;
+    }
+
+    if (!verifier.verify(components)) {
+        *output << "Reduced scheme is invalid: " << verifier.getError() << std::endl;
+        return false;
+    }
+
+    int additions = 0;
+    int freshVars = 0;
+
+    for (int i = 0; i < 3; i++) {
+        freshVars += components[i].freshVariables.size();
+
+        for (const auto &expression : components[i].expressions)
+            additions += std::max(int(expression.size()) - 1, 0);
+    }
+
+    *output << "Reduced scheme is valid: " << additions + freshVars << " additions (fresh vars: " << freshVars << ")" << std::endl;
+    return true;
+}
+
+const AdditionReducer& SchemeReducer::getInit(int index) const {
+    return init[index];
+}
+
+int SchemeReducer::getNaiveAdditions() const {
+    return naiveAdditions;
+}
+
+int SchemeReducer::getReducedAdditions() const {
+    return reducedAdditions;
+}
+
+int SchemeReducer::getReducedFreshVars() const {
+    return reducedFreshVars;
+}
+
+double SchemeReducer::getImprovementTime() const {
+    return improvementTime;
+}
+
 bool SchemeReducer::parseScheme(const Scheme &scheme) {
     for (int i = 0; i < 3; i++)
         dimension[i] = scheme.dimension[i];
@@ -121,78 +389,425 @@ bool SchemeReducer::parseScheme(const Scheme &scheme) {
 }
 
 void SchemeReducer::reduceIteration(int iteration, double partialInitializationRate) {
-    #pragma omp parallel for
+    if (numaReplicas)
+        replicate(best, localBest);
+
+    if (forkCount > 1)
+        reduceTrunks(iteration);
+
+    // every task initializes and reduces its reducer on the same thread, the static schedule keeps reducers on the same threads between iterations,
+    // so the reducer memory is first touched and then reused locally
+    #pragma omp parallel for collapse(2) schedule(static)
     for (int i = 0; i < count; i++) {
-        auto& generator = generators[omp_get_thread_num()];
+        for (int j = 0; j < 3; j++) {
+            if (optimal[j])
+                continue;
+
+            RandomGenerator generator(seed, getTaskStream(iteration, j, i));
+            int node = numaReplicas ? topology.getCurrentNode() : 0;
+
+            // tasks of a mirrored component reduce its source into the second half of the source reducers
+            int component = mirror[j] >= 0 ? mirror[j] : j;
+            int index = mirror[j] >= 0 ? count + i : i;
+            AdditionReducer &reducer = getReducer(component, index);
+            const AdditionReducer &initReducer = numaReplicas ? localInit[component][node] : init[component];
+            const AdditionReducer &bestReducer = numaReplicas ? localBest[component][node] : best[component];
+
+            reducer.copyFrom(initReducer);
+            reducer.setStrategy(iteration == 1 && i == 0 ? Strategy::Greedy : strategyWeights.select(generator));
+            reducer.setBeamWidth(strategyWeights.beamWidth);
+            reducer.setTasks(reducerTasks);
+
+            if (forkCount > 1) {
+                reducer.fork(trunks[j][i / forkCount]);
+            }
+            else if (crossoverRate > 0 && elites[component].size() > 1 && uniformDistribution(generator) < crossoverRate) {
+                std::uniform_int_distribution<int> eliteDistribution(0, elites[component].size() - 1);
+                int parent1 = eliteDistribution(generator);
+                int parent2 = eliteDistribution(generator);
+
+                while (parent2 == parent1)
+                    parent2 = eliteDistribution(generator);
+
+                std::uniform_int_distribution<int> varsDistribution(0, elites[component][parent1].sequence.size());
+                reducer.crossover(elites[component][parent1].sequence, varsDistribution(generator), elites[component][parent2].sequence);
+            }
+            else if (uniformDistribution(generator) < partialInitializationRate && bestReducer.getFreshVars() > 0) {
+                std::uniform_int_distribution<int> varsDistribution(1, bestReducer.getFreshVars() * 3 / 4);
+                reducer.partialInitialize(bestReducer, varsDistribution(generator));
+            }
+
+            reducer.reduce(generator);
+            storeRecord(component, index, reducer);
+        }
+    }
+}
+
+void SchemeReducer::reduceTrunks(int iteration) {
+    int groups = trunks[0].size();
 
+    // every group of forkCount reducers continues one trunk, so the common prefix of their eliminations is reduced once
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int i = 0; i < groups; i++) {
         for (int j = 0; j < 3; j++) {
-            uvw[j][i].copyFrom(init[j]);
-            uvw[j][i].setStrategy(iteration == 1 && i == 0 ? Strategy::Greedy : strategyWeights.select(generator));
+            if (optimal[j])
+                continue;
+
+            RandomGenerator generator(seed, getTaskStream(iteration, j, i, 2));
+            int component = mirror[j] >= 0 ? mirror[j] : j;
+            AdditionReducer &trunk = trunks[j][i];
+
+            trunk.copyFrom(init[component]);
+            trunk.setStrategy(strategyWeights.select(generator));
+            trunk.setBeamWidth(strategyWeights.beamWidth);
+            trunk.setTasks(reducerTasks);
+            trunk.reduceTrunk(generator, forkDepth * bestFreshVars[component]);
+        }
+    }
+}
 
-            if (uniformDistribution(generator) < partialInitializationRate && best[j].getFreshVars() > 0) {
-                std::uniform_int_distribution<int> varsDistribution(1, best[j].getFreshVars() * 3 / 4);
-                uvw[j][i].partialInitialize(best[j], varsDistribution(generator));
+void SchemeReducer::localSearchIteration(int iteration) {
+    #pragma omp parallel for collapse(2) schedule(dynamic)
+    for (int i = 0; i < count; i++) {
+        for (int j = 0; j < 3; j++) {
+            if (optimal[j])
+                continue;
+
+            RandomGenerator generator(seed, getTaskStream(iteration, j, i, 1));
+            int component = mirror[j] >= 0 ? mirror[j] : j;
+            int index = mirror[j] >= 0 ? count + i : i;
+            AdditionReducer &reducer = getReducer(component, index);
+
+            reducer.copyFrom(best[component]);
+            reducer.setStrategy(Strategy::LocalSearch);
+            reducer.setStrategyWeights(strategyWeights);
+            reducer.setTasks(reducerTasks);
+            reducer.localSearch(generator, localSearchSteps, init[component].getFreshVars());
+            storeRecord(component, index, reducer);
+        }
+    }
+}
+
+void SchemeReducer::solveExact(int startAdditions) {
+    bool improved = false;
+
+    for (int i = 0; i < 3; i++) {
+        if (mirror[i] >= 0)
+            optimal[i] = optimal[mirror[i]];
+
+        if (optimal[i])
+            continue;
+
+        ExactReducer exact(exactMaxNodes);
+        optimal[i] = exact.solve(init[i], best[i]);
+
+        if (exact.isImproved() && getScore(exact.getBest()) < getScore(best[i])) {
+            best[i].copyFrom(exact.getBest());
+            bestAdditions[i] = best[i].getAdditions();
+            bestFreshVars[i] = best[i].getFreshVars();
+            bestStrategies[i] = "exact";
+            improved = true;
+        }
+
+        *output << "Exact search for " << "UVW"[i] << " component: " << exact.getNodes() << " nodes, ";
+        *output << (optimal[i] ? "proven optimal" : "node limit reached") << " with " << bestAdditions[i] << " additions" << std::endl;
+    }
+
+    if (improved)
+        updateReduced(startAdditions);
+}
+
+void SchemeReducer::detectSymmetry() {
+    int n = dimension[0];
+    std::vector<std::pair<std::string, std::vector<int>>> candidates;
+
+    std::vector<int> identity(init[0].getMaxVariable() + 1);
+    std::iota(identity.begin(), identity.end(), 0);
+    candidates.push_back({"identity", identity});
+
+    // cyclic symmetric square schemes may store the next factor transposed
+    if (dimension[1] == n && dimension[2] == n) {
+        std::vector<int> transpose(n * n + 1, 0);
+
+        for (int row = 0; row < n; row++)
+            for (int column = 0; column < n; column++)
+                transpose[row * n + column + 1] = column * n + row + 1;
+
+        candidates.push_back({"transpose", transpose});
+    }
+
+    for (int j = 1; j < 3; j++) {
+        for (int k = 0; k < j && mirror[j] < 0; k++) {
+            if (mirror[k] >= 0)
+                continue;
+
+            for (const auto &candidate : candidates) {
+                if (!init[j].isPermutation(init[k], candidate.second))
+                    continue;
+
+                mirror[j] = k;
+                permutations[j] = candidate.second;
+                *output << "Symmetry detected: " << "UVW"[j] << " component is " << "UVW"[k] << " with " << candidate.first << " permutation of variables" << ", its reducers are given to " << "UVW"[k] << std::endl << std::endl;
+                break;
             }
         }
     }
 
-    #pragma omp parallel for collapse(2)
-    for (int i = 0; i < count; i++)
-        for (int j = 0; j < 3; j++)
-            uvw[j][i].reduce(generators[omp_get_thread_num()]);
+    for (int i = 0; i < 3; i++) {
+        if (mirror[i] < 0)
+            continue;
+
+        int source = mirror[i];
+        records[source].resize(records[source].size() + count);
+        scores[source].resize(records[source].size(), 0);
+
+        if (!compact)
+            uvw[source].resize(records[source].size());
+
+        for (int j = 0; j < count; j++)
+            indices[source].push_back(indices[source].size());
+    }
+}
+
+void SchemeReducer::updateMirrors() {
+    for (int i = 0; i < 3; i++) {
+        int source = mirror[i];
+
+        if (source < 0)
+            continue;
+
+        double sourceScore = getScore(best[source]);
+        double score = getScore(best[i]);
+
+        if (sourceScore > score || (sourceScore == score && bestFreshVars[source] >= bestFreshVars[i]))
+            continue;
+
+        AdditionReducer reducer;
+        reducer.copyFrom(init[i]);
+
+        // mapped sequence must give exactly the same cost, otherwise the component is reduced on its own
+        if (!reducer.applyPermutation(best[source], permutations[i]) || reducer.getAdditions() != bestAdditions[source] || reducer.getFreshVars() != bestFreshVars[source]) {
+            *output << "Mapped sequence of " << "UVW"[source] << " has different cost on " << "UVW"[i] << ", symmetry is disabled" << std::endl;
+            mirror[i] = -1;
+            continue;
+        }
+
+        bestAdditions[i] = bestAdditions[source];
+        bestFreshVars[i] = bestFreshVars[source];
+        bestStrategies[i] = bestStrategies[source];
+        best[i].copyFrom(reducer);
+    }
+}
+
+AdditionReducer& SchemeReducer::getReducer(int component, int index) {
+    return compact ? pool[omp_get_thread_num()] : uvw[component][index];
+}
+
+void SchemeReducer::storeRecord(int component, int index, const AdditionReducer &reducer) {
+    ReducerRecord &record = records[component][index];
+    record.additions = reducer.getAdditions();
+    record.freshVars = reducer.getFreshVars();
+    record.live = liveWeight > 0 || trafficWeight > 0 ? reducer.getMemoryCost().live : 0;
+    record.strategy = reducer.getStrategy();
+    scores[component][index] = getScore(reducer);
+
+    // the working reducer is reused by the next task of the thread, so only its sequence survives the iteration
+    if (compact) {
+        record.hash = crossoverRate > 0 ? reducer.getStateHash() : 0;
+        record.sequence = PackedSequence(reducer.getFreshVariables());
+    }
+}
+
+void SchemeReducer::restoreRecord(int component, int index, AdditionReducer &reducer) const {
+    // the best is replayed from the initial scheme in both modes, so its rows do not depend on how the reducer was kept
+    reducer.copyFrom(init[component]);
+    reducer.applyFreshVariables(compact ? records[component][index].sequence.unpack() : uvw[component][index].getFreshVariables());
+}
+
+void SchemeReducer::replicate(const AdditionReducer *source, std::vector<AdditionReducer> *replicas) {
+    int nodes = topology.getNodes();
+    std::vector<int> owners(nodes, -1);
+
+    for (int i = 0; i < 3; i++)
+        replicas[i].resize(nodes);
+
+    // the first thread found on every node copies the replica, rows are copied too instead of shared, so its pages are allocated on this node
+    #pragma omp parallel
+    {
+        int node = topology.getCurrentNode();
+
+        #pragma omp critical
+        if (owners[node] == -1)
+            owners[node] = omp_get_thread_num();
+
+        #pragma omp barrier
+
+        for (int node = 0; node < nodes; node++)
+            if (owners[node] == omp_get_thread_num())
+                for (int i = 0; i < 3; i++) {
+                    replicas[i][node].copyFrom(source[i]);
+                    replicas[i][node].unshare();
+                }
+    }
+
+    for (int node = 0; node < nodes; node++)
+        if (owners[node] == -1)
+            for (int i = 0; i < 3; i++) {
+                replicas[i][node].copyFrom(source[i]);
+                replicas[i][node].unshare();
+            }
 }
 
 bool SchemeReducer::updateBest(int index, int topCount) {
-    std::partial_sort(indices[index].begin(), indices[index].begin() + topCount, indices[index].end(), [this, index](int index1, int index2) {
-        int additions1 = uvw[index][index1].getAdditions();
-        int additions2 = uvw[index][index2].getAdditions();
+    int sorted = std::min((int) indices[index].size(), std::max(topCount, crossoverRate > 0 ? eliteCount : 0));
 
-        if (additions1 != additions2)
-            return additions1 < additions2;
+    // scores and costs are stored by reducer tasks, so ranking walks no expressions
+    std::partial_sort(indices[index].begin(), indices[index].begin() + sorted, indices[index].end(), [this, index](int index1, int index2) {
+        double score1 = scores[index][index1];
+        double score2 = scores[index][index2];
 
-        return uvw[index][index1].getFreshVars() < uvw[index][index2].getFreshVars();
+        if (score1 != score2)
+            return score1 < score2;
+
+        return records[index][index1].freshVars < records[index][index2].freshVars;
     });
 
+    updateElites(index, sorted);
+
     int top = indices[index][0];
-    int additions = uvw[index][top].getAdditions();
-    int freshVars = uvw[index][top].getFreshVars();
-    std::string strategy = uvw[index][top].getStrategy();
-
-    if (additions < bestAdditions[index] || (additions == bestAdditions[index] && freshVars < bestFreshVars[index])) {
-        bestAdditions[index] = additions;
-        bestFreshVars[index] = freshVars;
-        bestStrategies[index] = strategy;
-        best[index].copyFrom(uvw[index][top]);
+    const ReducerRecord &record = records[index][top];
+    double score = scores[index][top];
+    double bestScore = getScore(best[index]);
+
+    if (score < bestScore || (score == bestScore && record.freshVars < bestFreshVars[index])) {
+        bestAdditions[index] = record.additions;
+        bestFreshVars[index] = record.freshVars;
+        bestStrategies[index] = record.strategy;
+        restoreRecord(index, top, best[index]);
         return true;
     }
 
     return false;
 }
 
+void SchemeReducer::updateElites(int index, int sorted) {
+    if (crossoverRate <= 0 || !PackedSequence::canPack(init[index].getMaxVariable()))
+        return;
+
+    auto isBetter = [](const Elite &elite1, const Elite &elite2) {
+        if (elite1.additions != elite2.additions)
+            return elite1.additions < elite2.additions;
+
+        return elite1.freshVars < elite2.freshVars;
+    };
+
+    for (int i = 0; i < sorted; i++) {
+        int reducerIndex = indices[index][i];
+        const ReducerRecord &record = records[index][reducerIndex];
+        Elite elite = {record.additions, record.freshVars, 0, PackedSequence()};
+
+        // reducers are sorted, so the rest are not better than the worst elite too
+        if ((int) elites[index].size() >= eliteCount && !isBetter(elite, elites[index].back()))
+            break;
+
+        elite.hash = compact ? record.hash : uvw[index][reducerIndex].getStateHash();
+
+        bool duplicate = false;
+        for (const auto &other : elites[index])
+            if (other.hash == elite.hash)
+                duplicate = true;
+
+        if (duplicate)
+            continue;
+
+        elite.sequence = compact ? record.sequence : PackedSequence(uvw[index][reducerIndex].getFreshVariables());
+        elites[index].insert(std::upper_bound(elites[index].begin(), elites[index].end(), elite, isBetter), elite);
+
+        if ((int) elites[index].size() > eliteCount)
+            elites[index].pop_back();
+    }
+}
+
 bool SchemeReducer::update(int startAdditions, int topCount) {
     bool updated = false;
 
     for (int i = 0; i < 3; i++)
-        if (updateBest(i, topCount))
+        if (mirror[i] < 0 && updateBest(i, topCount))
             updated = true;
 
     if (!updated)
         return false;
 
+    updateReduced(startAdditions);
+    return true;
+}
+
+void SchemeReducer::updateReduced(int startAdditions) {
+    updateMirrors();
+
     int additions = bestAdditions[0] + bestAdditions[1] + bestAdditions[2];
     int freshVars = bestFreshVars[0] + bestFreshVars[1] + bestFreshVars[2];
 
     if (additions < reducedAdditions)
-        std::cout << "Reduced scheme improved from " << reducedAdditions << " to " << additions << " additions (fresh vars: " << freshVars << ")" << std::endl;
+        *output << "Reduced scheme improved from " << reducedAdditions << " to " << additions << " additions (fresh vars: " << freshVars << ")" << std::endl;
+    else if (additions > reducedAdditions || freshVars >= reducedFreshVars)
+        *output << "Reduced scheme memory cost improved (additions: " << additions << ", fresh vars: " << freshVars << ")" << std::endl;
     else
-        std::cout << "Reduced scheme improved from " << reducedFreshVars << " fresh vars to " << freshVars << " fresh vars (additions: " << reducedAdditions << ")" << std::endl;
+        *output << "Reduced scheme improved from " << reducedFreshVars << " fresh vars to " << freshVars << " fresh vars (additions: " << reducedAdditions << ")" << std::endl;
 
     reducedAdditions = additions;
     reducedFreshVars = freshVars;
 
-    if (reducedAdditions < startAdditions || startAdditions == 0)
+    if (saving && (reducedAdditions < startAdditions || startAdditions == 0))
         save();
+}
+
+bool SchemeReducer::exchangeBest(int startAdditions) {
+    bool received = false;
+
+    for (int i = 0; i < 3; i++) {
+        std::string name = getExchangeName(i);
+
+        if (bestAdditions[i] < publishedAdditions[i] || (bestAdditions[i] == publishedAdditions[i] && bestFreshVars[i] < publishedFreshVars[i])) {
+            if (exchange->publish(name, {worker, bestAdditions[i], bestFreshVars[i], best[i].getFreshVariables()})) {
+                publishedAdditions[i] = bestAdditions[i];
+                publishedFreshVars[i] = bestFreshVars[i];
+            }
+        }
+
+        ExchangeRecord record;
+        if (exchange->pull(name, record, init[i].getNaiveAdditions()) && adoptRecord(i, record)) {
+            // do not publish back sequence received from the coordinator
+            publishedAdditions[i] = bestAdditions[i];
+            publishedFreshVars[i] = bestFreshVars[i];
+            received = true;
+        }
+    }
+
+    if (received) {
+        *output << "Received improved best from the coordinator" << std::endl;
+        updateReduced(startAdditions);
+    }
+
+    return received;
+}
 
+bool SchemeReducer::adoptRecord(int index, const ExchangeRecord &record) {
+    if (record.additions > bestAdditions[index] || (record.additions == bestAdditions[index] && record.freshVars >= bestFreshVars[index]))
+        return false;
+
+    AdditionReducer reducer;
+    reducer.copyFrom(init[index]);
+
+    if (!reducer.applyFreshVariables(record.freshVariables) || reducer.getAdditions() != record.additions || reducer.getFreshVars() != record.freshVars) {
+        *output << "Skip invalid record of " << getExchangeName(index) << " from \"" << record.worker << "\"" << std::endl;
+        return false;
+    }
+
+    bestAdditions[index] = record.additions;
+    bestFreshVars[index] = record.freshVars;
+    bestStrategies[index] = record.worker;
+    best[index].copyFrom(reducer);
     return true;
 }
 
@@ -206,59 +821,121 @@ void SchemeReducer::report(std::chrono::high_resolution_clock::time_point startT
 
     std::string dimension = getDimension();
 
-    std::cout << std::endl;
-    std::cout << "+--------------------------------------------------------------------------------------------------------+" << std::endl;
-    std::cout << "| " << std::left;
-    std::cout << "Size: " << std::setw(20) << dimension << "   ";
-    std::cout << "Reducers count: " << std::setw(10) << count << "   ";
-    std::cout << std::setw(44) << std::right << ("Iteration: " + std::to_string(iteration));
-    std::cout << " |" << std::endl;
-
-    std::cout << "| " << std::left;
-    std::cout << "Rank: " << std::setw(20) << rank << "   ";
-    std::cout << "Naive additions: " << std::setw(9) << naiveAdditions << "   ";
-    std::cout <<  std::setw(44) << std::right << ("Elapsed: " + prettyTime(elapsed));
-    std::cout << " |" << std::endl;
-
-    std::cout << std::right;
-    std::cout << "+============================+============================+============================+=================+" << std::endl;
-    std::cout << "|         Reducers U         |         Reducers V         |         Reducers W         |      Total      |" << std::endl;
-    std::cout << "+----------+---------+-------+----------+---------+-------+----------+---------+-------+---------+-------+" << std::endl;
-    std::cout << "| strategy | reduced | fresh | strategy | reduced | fresh | strategy | reduced | fresh | reduced | fresh |" << std::endl;
-    std::cout << "+----------+---------+-------+----------+---------+-------+----------+---------+-------+---------+-------+" << std::endl;
+    // with the memory model every component also shows peak live temporaries, and the total shows the score
+    bool memory = liveWeight > 0 || trafficWeight > 0;
+    std::vector<int> componentWidths = memory ? std::vector<int>{10, 9, 7, 6} : std::vector<int>{10, 9, 7};
+    std::vector<int> totalWidths = memory ? std::vector<int>{9, 7, 9} : std::vector<int>{9, 7};
+    int extra = memory ? 21 : 0;
+
+    auto border = [this, &componentWidths, &totalWidths](char fill, bool columns) {
+        *output << "+";
+
+        for (int j = 0; j < 4; j++) {
+            const std::vector<int> &widths = j < 3 ? componentWidths : totalWidths;
+
+            for (size_t k = 0; k < widths.size(); k++)
+                *output << std::string(widths[k], fill) << (columns || k == widths.size() - 1 ? '+' : fill);
+        }
+
+        *output << std::endl;
+    };
+
+    auto title = [this](const std::string &text, const std::vector<int> &widths) {
+        int width = std::accumulate(widths.begin(), widths.end(), 0) + widths.size() - 1;
+        int left = (width - text.size()) / 2;
+        *output << std::string(left, ' ') << text << std::string(width - left - text.size(), ' ') << "|";
+    };
+
+    *output << std::endl;
+    *output << "+" << std::string(104 + extra, '-') << "+" << std::endl;
+    *output << "| " << std::left;
+    *output << "Size: " << std::setw(20) << dimension << "   ";
+    *output << "Reducers count: " << std::setw(10) << count << "   ";
+    *output << std::setw(44 + extra) << std::right << ("Iteration: " + std::to_string(iteration));
+    *output << " |" << std::endl;
+
+    *output << "| " << std::left;
+    *output << "Rank: " << std::setw(20) << rank << "   ";
+    *output << "Naive additions: " << std::setw(9) << naiveAdditions << "   ";
+    *output <<  std::setw(44 + extra) << std::right << ("Elapsed: " + prettyTime(elapsed));
+    *output << " |" << std::endl;
+
+    *output << std::right;
+    border('=', false);
+    *output << "|";
+    title("Reducers U", componentWidths);
+    title("Reducers V", componentWidths);
+    title("Reducers W", componentWidths);
+    title("Total", totalWidths);
+    *output << std::endl;
+    border('-', true);
+    *output << "|";
+
+    for (int j = 0; j < 3; j++)
+        *output << " strategy | reduced | fresh |" << (memory ? " live |" : "");
+
+    *output << " reduced | fresh |" << (memory ? "   score |" : "") << std::endl;
+    border('-', true);
 
     for (int i = 0; i < topCount && i < count; i++) {
-        std::cout << "| ";
+        *output << "| ";
 
         int reduced = 0;
         int fresh = 0;
+        double score = 0;
 
         for (int j = 0; j < 3; j++) {
-            int index = indices[j][i];
-            std::string strategy = uvw[j][index].getStrategy();
-            int currReduced = uvw[j][index].getAdditions();
-            int currFresh = uvw[j][index].getFreshVars();
+            int component = mirror[j] >= 0 ? mirror[j] : j;
+            int index = indices[component][i];
+            const ReducerRecord &record = records[component][index];
+            const std::string &strategy = record.strategy;
+            int currReduced = record.additions;
+            int currFresh = record.freshVars;
 
             reduced += currReduced;
             fresh += currFresh;
+            score += scores[component][index];
+
+            *output << std::left << std::setw(8) << strategy << "   " << std::right << std::setw(7) << currReduced << "   " << std::setw(5) << currFresh << " | ";
 
-            std::cout << std::left << std::setw(8) << strategy << "   " << std::right << std::setw(7) << currReduced << "   " << std::setw(5) << currFresh << " | ";
+            if (memory)
+                *output << std::setw(4) << record.live << " | ";
         }
 
-        std::cout << std::setw(7) << reduced << "   " << std::setw(5) << fresh << " | ";
-        std::cout << std::endl;
+        *output << std::setw(7) << reduced << "   " << std::setw(5) << fresh << " | ";
+
+        if (memory)
+            *output << std::setw(7) << std::fixed << std::setprecision(1) << score << std::defaultfloat << " | ";
+
+        *output << std::endl;
+    }
+
+    border('-', false);
+    *output << "- iteration time (last / min / max / mean): " << prettyTime(lastTime) << " / " << prettyTime(minTime) << " / " << prettyTime(maxTime) << " / " << prettyTime(meanTime) << std::endl;
+    *output << "- best additions (U / V / W / total): " << bestAdditions[0] << " / " << bestAdditions[1] << " / " << bestAdditions[2] << " / " << reducedAdditions << std::endl;
+    *output << "- best fresh vars (U / V / W / total): " << bestFreshVars[0] << " / " << bestFreshVars[1] << " / " << bestFreshVars[2] << " / " << reducedFreshVars << std::endl;
+    *output << "- best strategies (U / V / W): " << bestStrategies[0] << " / " << bestStrategies[1] << " / " << bestStrategies[2] << std::endl;
+
+    if (memory) {
+        MemoryCost costs[3] = {best[0].getMemoryCost(), best[1].getMemoryCost(), best[2].getMemoryCost()};
+        *output << "- best live temporaries (U / V / W): " << costs[0].live << " / " << costs[1].live << " / " << costs[2].live << std::endl;
+        *output << "- best memory traffic (U / V / W / total): " << costs[0].traffic << " / " << costs[1].traffic << " / " << costs[2].traffic << " / " << costs[0].traffic + costs[1].traffic + costs[2].traffic << std::endl;
     }
 
-    std::cout << "+----------------------------+----------------------------+----------------------------+-----------------+" << std::endl;
-    std::cout << "- iteration time (last / min / max / mean): " << prettyTime(lastTime) << " / " << prettyTime(minTime) << " / " << prettyTime(maxTime) << " / " << prettyTime(meanTime) << std::endl;
-    std::cout << "- best additions (U / V / W / total): " << bestAdditions[0] << " / " << bestAdditions[1] << " / " << bestAdditions[2] << " / " << reducedAdditions << std::endl;
-    std::cout << "- best fresh vars (U / V / W / total): " << bestFreshVars[0] << " / " << bestFreshVars[1] << " / " << bestFreshVars[2] << " / " << reducedFreshVars << std::endl;
-    std::cout << "- best strategies (U / V / W): " << bestStrategies[0] << " / " << bestStrategies[1] << " / " << bestStrategies[2] << std::endl;
-    std::cout << std::endl;
+    if (exactMaxNodes > 0)
+        *output << "- proven optimal (U / V / W): " << (optimal[0] ? "yes" : "no") << " / " << (optimal[1] ? "yes" : "no") << " / " << (optimal[2] ? "yes" : "no") << std::endl;
+
+    *output << std::endl;
 }
 
 void SchemeReducer::save() const {
     std::string path = getSavePath();
+    std::string error;
+
+    if (verifySaves && !verifyBest(error)) {
+        *output << "Reduced scheme is not saved, verification failed: " << error << std::endl;
+        return;
+    }
 
     std::ofstream f(path);
 
@@ -276,7 +953,50 @@ void SchemeReducer::save() const {
     f << "}" << std::endl;
     f.close();
 
-    std::cout << "Reduced scheme saved to \"" << path << "\"" << std::endl;
+    *output << "Reduced scheme saved to \"" << path << "\"" << std::endl;
+
+    if (!generateCode)
+        return;
+
+    std::string codePath = path.substr(0, path.size() - 4) + "h";
+    std::ofstream code(codePath);
+
+    CodeGenerator generator(dimension, rank);
+    generator.generate(code, best);
+    code.close();
+
+    *output << "Reduced scheme code saved to \"" << codePath << "\"" << std::endl;
+}
+
+bool SchemeReducer::verifyBest(std::string &error) const {
+    std::vector<std::unordered_set<int>> rows[3] = {init[0].getExpressions().unpack(), init[1].getExpressions().unpack(), init[2].getExpressions().unpack()};
+    SchemeVerifier verifier(dimension, rank, rows);
+    ReducedComponent components[3];
+
+    for (int i = 0; i < 3; i++) {
+        components[i].freshVariables = best[i].getFreshVariables();
+
+        for (const auto &expression : best[i].getExpressions())
+            components[i].expressions.push_back(std::vector<int>(expression.begin(), expression.end()));
+    }
+
+    if (verifier.verify(components))
+        return true;
+
+    error = verifier.getError();
+    return false;
+}
+
+double SchemeReducer::getScore(const AdditionReducer &reducer) const {
+    if (liveWeight <= 0 && trafficWeight <= 0)
+        return reducer.getAdditions();
+
+    MemoryCost cost = reducer.getMemoryCost();
+    return reducer.getAdditions() + liveWeight * cost.live + trafficWeight * cost.traffic;
+}
+
+uint64_t SchemeReducer::getTaskStream(int iteration, int component, int index, int phase) const {
+    return (((uint64_t) iteration * 3 + component) * count + index) ^ ((uint64_t) phase << 56);
 }
 
 std::string SchemeReducer::getSavePath() const {
@@ -287,12 +1007,22 @@ std::string SchemeReducer::getSavePath() const {
     ss << "_cr" << reducedAdditions;
     ss << "_fv" << reducedFreshVars;
     ss << "_cn" << naiveAdditions;
+
+    if (variant > 0)
+        ss << "_v" << variant;
+
     ss << "_ZT";
     ss << "_reduced.json";
 
     return ss.str();
 }
 
+std::string SchemeReducer::getExchangeName(int index) const {
+    std::stringstream ss;
+    ss << getDimension() << "_m" << rank << "_" << "uvw"[index];
+    return ss.str();
+}
+
 std::string SchemeReducer::getDimension() const {
     std::stringstream ss;
     ss << dimension[0] << "x" << dimension[1] << "x" << dimension[2];
@@ -9,18 +9,50 @@
 #include <algorithm>
 #include <numeric>
 #include <random>
+#include <thread>
 #include <omp.h>
 
 #include "scheme.h"
 #include "addition_reducer.h"
+#include "best_exchange.h"
+#include "numa_topology.h"
+#include "exact_reducer.h"
+#include "code_generator.h"
+#include "scheme_verifier.h"
+
+struct Elite {
+    int additions;
+    int freshVars;
+    uint64_t hash;
+    PackedSequence sequence;
+};
+
+// finished reducer as kept between iterations: costs for ranking and reporting, in compact mode also its packed sequence
+struct ReducerRecord {
+    int additions;
+    int freshVars;
+    int live;
+    uint64_t hash;
+    std::string strategy;
+    PackedSequence sequence;
+};
 
 class SchemeReducer {
     int dimension[3];
     int rank;
     int count;
+    int seed;
 
     std::string path;
+    std::ostream *output;
+    int variant;
+    bool saving;
+    double maxTime;
+    double improvementTime;
     std::vector<AdditionReducer> uvw[3];
+    std::vector<ReducerRecord> records[3];
+    std::vector<AdditionReducer> pool;
+    bool compact;
     AdditionReducer init[3];
     AdditionReducer best[3];
     StrategyWeights strategyWeights;
@@ -29,28 +61,101 @@ class SchemeReducer {
     int bestFreshVars[3];
     std::string bestStrategies[3];
     std::vector<int> indices[3];
-    std::vector<std::mt19937> generators;
+
+    NumaTopology topology;
+    bool numaReplicas;
+    std::vector<AdditionReducer> localInit[3];
+    std::vector<AdditionReducer> localBest[3];
 
     int naiveAdditions;
     int reducedAdditions;
     int reducedFreshVars;
 
+    BestExchange *exchange;
+    std::string worker;
+    int exchangeInterval;
+    int localSearchSteps;
+    double crossoverRate;
+    int eliteCount;
+    std::vector<Elite> elites[3];
+    long exactMaxNodes;
+    bool optimal[3];
+    bool symmetry;
+    bool duplicates;
+    RowStorage rowStorage;
+    bool generateCode;
+    bool verifySaves;
+    int reducerTasks;
+    int forkCount;
+    double forkDepth;
+    std::vector<AdditionReducer> trunks[3];
+    double liveWeight;
+    double trafficWeight;
+    std::vector<double> scores[3];
+    int mirror[3];
+    std::vector<int> permutations[3];
+    int publishedAdditions[3];
+    int publishedFreshVars[3];
+
     std::uniform_real_distribution<double> uniformDistribution;
 public:
     SchemeReducer(int count, const std::string path, const StrategyWeights &strategyWeights, int seed);
 
     bool initialize(std::istream &is);
+    bool initialize(const Scheme &scheme);
     void reduce(int maxNoImprovements, int startAdditions, double partialInitializationRate, int topCount = 10);
+    void reduceIteration(int iteration, double partialInitializationRate);
+    void localSearchIteration(int iteration);
+    void reduceTrunks(int iteration);
+    void setLocalSearch(int localSearchSteps);
+    void setCrossover(double crossoverRate, int eliteCount);
+    void setExact(long exactMaxNodes);
+    void setSymmetry(bool symmetry);
+    void setDuplicates(bool duplicates);
+    void setRowStorage(RowStorage rowStorage);
+    void setCompact(bool compact);
+    void setCodeGeneration(bool generateCode);
+    void setVerification(bool verifySaves);
+    void setSaving(bool saving, int variant = 0);
+    void setMaxTime(double maxTime);
+    void setOutput(std::ostream &output);
+    void setReducerTasks(int reducerTasks);
+    void setFork(int forkCount, double forkDepth);
+    void setMemoryModel(double liveWeight, double trafficWeight);
+    bool setNuma(bool replicas, bool pinThreads);
+    void setExchange(BestExchange *exchange, const std::string &worker, int exchangeInterval);
+    void coordinate(BestExchange &exchange, double interval, double timeout, int startAdditions);
+    bool verify(std::istream &is) const;
+
+    const AdditionReducer& getInit(int index) const;
+    int getNaiveAdditions() const;
+    int getReducedAdditions() const;
+    int getReducedFreshVars() const;
+    double getImprovementTime() const;
 private:
     bool parseScheme(const Scheme &scheme);
-    void reduceIteration(int iteration, double partialInitializationRate);
+    void detectSymmetry();
+    void updateMirrors();
+    AdditionReducer& getReducer(int component, int index);
+    void storeRecord(int component, int index, const AdditionReducer &reducer);
+    void restoreRecord(int component, int index, AdditionReducer &reducer) const;
+    void replicate(const AdditionReducer *source, std::vector<AdditionReducer> *replicas);
+    void solveExact(int startAdditions);
     bool updateBest(int index, int topCount);
+    void updateElites(int index, int sorted);
     bool update(int startAdditions, int topCount);
+    void updateReduced(int startAdditions);
+    bool exchangeBest(int startAdditions);
+    bool adoptRecord(int index, const ExchangeRecord &record);
     void report(std::chrono::high_resolution_clock::time_point startTime, int iteration, const std::vector<double> &elapsedTimes, int topCount);
     void save() const;
+    bool verifyBest(std::string &error) const;
 
-    Strategy selectStrategy(std::mt19937 &generator);
+    Strategy selectStrategy(RandomGenerator &generator);
+    double getScore(const AdditionReducer &reducer) const;
+    uint64_t getTaskStream(int iteration, int component, int index, int phase = 0) const;
     std::string getSavePath() const;
+    std::string getExchangeName(int index) const;
     std::string getDimension() const;
     std::string prettyTime(double elapsed) const;
 };
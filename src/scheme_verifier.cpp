@@ -0,0 +1,270 @@
+#include "scheme_verifier.h"
+
+SchemeVerifier::SchemeVerifier(const int *dimension, int rank, const std::vector<std::unordered_set<int>> *rows) {
+    for (int i = 0; i < 3; i++)
+        this->dimension[i] = dimension[i];
+
+    this->elements[0] = dimension[0] * dimension[1];
+    this->elements[1] = dimension[1] * dimension[2];
+    this->elements[2] = dimension[2] * dimension[0];
+    this->rank = rank;
+
+    for (int i = 0; i < 3; i++)
+        for (const auto &row : rows[i])
+            this->rows[i].push_back(std::vector<int>(row.begin(), row.end()));
+}
+
+bool SchemeVerifier::verify(const ReducedComponent *components) {
+    std::vector<TernaryForm> forms[3];
+    error = "";
+
+    for (int i = 0; i < 3; i++)
+        if (!expand(i, components[i], forms[i]))
+            return false;
+
+    return validateBrent(forms);
+}
+
+bool SchemeVerifier::read(std::istream &is, ReducedComponent *components) {
+    std::stringstream ss;
+    ss << is.rdbuf();
+    std::string text = ss.str();
+
+    for (int i = 0; i < 3; i++) {
+        std::string name = std::string(1, "uvw"[i]);
+        std::vector<std::vector<int>> freshVariables;
+
+        if (!readRows(text, "\"" + name + "_fresh\"", freshVariables) || !readRows(text, "\"" + name + "\"", components[i].expressions))
+            return false;
+
+        components[i].freshVariables.clear();
+
+        for (const auto &variable : freshVariables) {
+            if (variable.size() != 2) {
+                error = "fresh variable of " + name + " has " + std::to_string(variable.size()) + " operands";
+                return false;
+            }
+
+            components[i].freshVariables.push_back({variable[0], variable[1]});
+        }
+    }
+
+    return true;
+}
+
+const std::string& SchemeVerifier::getError() const {
+    return error;
+}
+
+bool SchemeVerifier::expand(int index, const ReducedComponent &component, std::vector<TernaryForm> &forms) {
+    std::string name = std::string(1, "UVW"[index]);
+    int realVariables = index < 2 ? elements[index] : rank;
+    int freshVariables = component.freshVariables.size();
+    std::vector<TernaryForm> values(realVariables + freshVariables + 1);
+
+    for (int variable = 1; variable <= realVariables; variable++)
+        values[variable] = getForm({variable}, realVariables);
+
+    for (int k = 0; k < freshVariables; k++) {
+        int variables[2] = {component.freshVariables[k].first, component.freshVariables[k].second};
+        TernaryForm &form = values[realVariables + k + 1];
+        form = getForm({}, realVariables);
+
+        for (int variable : variables) {
+            if (variable == 0 || abs(variable) > realVariables + k) {
+                error = name + " fresh variable " + std::to_string(k) + " uses unknown variable " + std::to_string(variable);
+                return false;
+            }
+
+            if (!add(form, values[abs(variable)], variable > 0 ? 1 : -1)) {
+                error = name + " fresh variable " + std::to_string(k) + " has non ternary coefficients";
+                return false;
+            }
+        }
+    }
+
+    if (component.expressions.size() != rows[index].size()) {
+        error = name + " has " + std::to_string(component.expressions.size()) + " expressions instead of " + std::to_string(rows[index].size());
+        return false;
+    }
+
+    forms.clear();
+
+    for (size_t i = 0; i < component.expressions.size(); i++) {
+        TernaryForm form = getForm({}, realVariables);
+
+        for (int variable : component.expressions[i]) {
+            if (variable == 0 || abs(variable) > realVariables + freshVariables) {
+                error = name + " expression " + std::to_string(i) + " uses unknown variable " + std::to_string(variable);
+                return false;
+            }
+
+            if (!add(form, values[abs(variable)], variable > 0 ? 1 : -1)) {
+                error = name + " expression " + std::to_string(i) + " has non ternary coefficients";
+                return false;
+            }
+        }
+
+        TernaryForm expected = getForm(rows[index][i], realVariables);
+
+        if (form.positive != expected.positive || form.negative != expected.negative) {
+            error = name + " expression " + std::to_string(i) + " differs from the initial scheme";
+            return false;
+        }
+
+        forms.push_back(form);
+    }
+
+    return true;
+}
+
+bool SchemeVerifier::validateBrent(const std::vector<TernaryForm> *forms) {
+    std::vector<std::vector<std::pair<int, int>>> terms[3];
+
+    for (int i = 0; i < 3; i++)
+        terms[i].resize(rank);
+
+    // nonzero coefficients of every product, W rows are transposed back to products
+    for (int i = 0; i < 3; i++) {
+        int size = i < 2 ? elements[i] : rank;
+
+        for (size_t row = 0; row < forms[i].size(); row++) {
+            for (int variable = 1; variable <= size; variable++) {
+                int value;
+                if (!getCoefficient(forms[i][row], variable, value))
+                    continue;
+
+                if (i < 2)
+                    terms[i][row].push_back({variable - 1, value});
+                else
+                    terms[i][variable - 1].push_back({row, value});
+            }
+        }
+    }
+
+    std::vector<int> tensor(elements[0] * elements[1] * elements[2], 0);
+
+    for (int index = 0; index < rank; index++)
+        for (const auto &u : terms[0][index])
+            for (const auto &v : terms[1][index])
+                for (const auto &w : terms[2][index])
+                    tensor[(u.first * elements[1] + v.first) * elements[2] + w.first] += u.second * v.second * w.second;
+
+    for (int i = 0; i < elements[0]; i++) {
+        for (int j = 0; j < elements[1]; j++) {
+            for (int k = 0; k < elements[2]; k++) {
+                int i1 = i / dimension[1];
+                int i2 = i % dimension[1];
+                int j1 = j / dimension[2];
+                int j2 = j % dimension[2];
+                int k1 = k / dimension[0];
+                int k2 = k % dimension[0];
+                int target = (i2 == j1) && (i1 == k2) && (j2 == k1);
+
+                if (tensor[(i * elements[1] + j) * elements[2] + k] != target) {
+                    error = "Brent equation (" + std::to_string(i) + ", " + std::to_string(j) + ", " + std::to_string(k) + ") is not satisfied";
+                    return false;
+                }
+            }
+        }
+    }
+
+    return true;
+}
+
+bool SchemeVerifier::add(TernaryForm &form, const TernaryForm &term, int sign) const {
+    const std::vector<uint64_t> &positive = sign > 0 ? term.positive : term.negative;
+    const std::vector<uint64_t> &negative = sign > 0 ? term.negative : term.positive;
+
+    // supports of summands are disjoint in a correct elimination sequence, otherwise coefficients leave {-1, 0, 1} or cancel
+    for (size_t i = 0; i < form.positive.size(); i++) {
+        if ((form.positive[i] | form.negative[i]) & (positive[i] | negative[i]))
+            return false;
+
+        form.positive[i] |= positive[i];
+        form.negative[i] |= negative[i];
+    }
+
+    return true;
+}
+
+TernaryForm SchemeVerifier::getForm(const std::vector<int> &expression, int variables) const {
+    size_t words = (variables + 63) / 64;
+    TernaryForm form = {std::vector<uint64_t>(words, 0), std::vector<uint64_t>(words, 0)};
+
+    for (int variable : expression) {
+        int bit = abs(variable) - 1;
+        std::vector<uint64_t> &target = variable > 0 ? form.positive : form.negative;
+        target[bit / 64] |= uint64_t(1) << (bit % 64);
+    }
+
+    return form;
+}
+
+bool SchemeVerifier::getCoefficient(const TernaryForm &form, int variable, int &value) const {
+    int bit = variable - 1;
+    uint64_t mask = uint64_t(1) << (bit % 64);
+
+    if (form.positive[bit / 64] & mask) {
+        value = 1;
+        return true;
+    }
+
+    if (form.negative[bit / 64] & mask) {
+        value = -1;
+        return true;
+    }
+
+    return false;
+}
+
+bool SchemeVerifier::readRows(const std::string &text, const std::string &key, std::vector<std::vector<int>> &values) const {
+    size_t position = text.find(key);
+    if (position == std::string::npos)
+        return false;
+
+    position = text.find('[', position + key.size());
+    if (position == std::string::npos)
+        return false;
+
+    values.clear();
+    int depth = 0;
+    int index = 0;
+    int value = 0;
+
+    for (; position < text.size(); position++) {
+        char c = text[position];
+
+        if (c == '[') {
+            depth++;
+
+            if (depth == 2)
+                values.push_back({});
+        }
+        else if (c == ']') {
+            if (--depth == 0)
+                return true;
+        }
+        else if (c == '}' && depth == 2) {
+            values.back().push_back((index + 1) * value);
+        }
+        else if (c == '"') {
+            size_t end = text.find('"', position + 1);
+            size_t colon = text.find(':', end);
+            if (end == std::string::npos || colon == std::string::npos)
+                return false;
+
+            std::string name = text.substr(position + 1, end - position - 1);
+            int number = std::strtol(text.c_str() + colon + 1, nullptr, 10);
+
+            if (name == "index")
+                index = number;
+            else if (name == "value")
+                value = number;
+
+            position = end;
+        }
+    }
+
+    return false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <unordered_set>
+
+// reduced component as saved: fresh variables and expressions of signed 1-based variables
+struct ReducedComponent {
+    std::vector<std::pair<int, int>> freshVariables;
+    std::vector<std::vector<int>> expressions;
+};
+
+// ternary linear form over real variables, coefficients are kept in two bitsets
+struct TernaryForm {
+    std::vector<uint64_t> positive;
+    std::vector<uint64_t> negative;
+};
+
+// checks reduced components independently of the reducer: expands fresh variables, compares with initial rows and validates Brent equations
+class SchemeVerifier {
+    int dimension[3];
+    int elements[3];
+    int rank;
+    std::vector<std::vector<int>> rows[3];
+    std::string error;
+public:
+    SchemeVerifier(const int *dimension, int rank, const std::vector<std::unordered_set<int>> *rows);
+
+    bool verify(const ReducedComponent *components);
+    bool read(std::istream &is, ReducedComponent *components);
+    const std::string& getError() const;
+private:
+    bool expand(int index, const ReducedComponent &component, std::vector<TernaryForm> &forms);
+    bool validateBrent(const std::vector<TernaryForm> *forms);
+    bool add(TernaryForm &form, const TernaryForm &term, int sign) const;
+    TernaryForm getForm(const std::vector<int> &expression, int variables) const;
+    bool getCoefficient(const TernaryForm &form, int variable, int &value) const;
+    bool readRows(const std::string &text, const std::string &key, std::vector<std::vector<int>> &values) const;
+};
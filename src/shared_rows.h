@@ -0,0 +1,162 @@
+#pragma once
+
+#include <vector>
+#include <memory>
+
+// rows shared between copies of reducers: a copy shares the table of rows, the first modification copies the table of pointers
+// and then the modified row, so the copy cost is constant and the memory grows with the number of modified rows, not with the scheme size
+template <typename T>
+class SharedRows {
+    typedef std::vector<std::shared_ptr<T>> Table;
+
+    std::shared_ptr<Table> rows;
+public:
+    class const_iterator {
+        typename Table::const_iterator it;
+    public:
+        const_iterator(typename Table::const_iterator it) : it(it) {
+        }
+
+        const T& operator*() const {
+            return **it;
+        }
+
+        const_iterator& operator++() {
+            ++it;
+            return *this;
+        }
+
+        bool operator!=(const const_iterator &iterator) const {
+            return it != iterator.it;
+        }
+    };
+
+    SharedRows() : rows(std::make_shared<Table>()) {
+    }
+
+    size_t size() const {
+        return rows->size();
+    }
+
+    const T& operator[](size_t index) const {
+        return *(*rows)[index];
+    }
+
+    // the only row is not shared: other copies can get it only by copying this one
+    T& modify(size_t index) {
+        std::shared_ptr<T> &row = getTable()[index];
+
+        if (row.use_count() > 1)
+            row = std::make_shared<T>(*row);
+
+        return *row;
+    }
+
+    void push_back(const T &row) {
+        getTable().push_back(std::make_shared<T>(row));
+    }
+
+    // new rows are empty
+    void resize(size_t size) {
+        Table &table = getTable();
+
+        while (table.size() < size)
+            table.push_back(std::make_shared<T>());
+
+        table.resize(size);
+    }
+
+    // moves rows without copying them
+    void swap(size_t index1, size_t index2) {
+        std::swap(getTable()[index1], getTable()[index2]);
+    }
+
+    void clear() {
+        rows = std::make_shared<Table>();
+    }
+
+    // copies the table and all rows, so nothing is shared with other copies
+    void unshare() {
+        std::shared_ptr<Table> table = std::make_shared<Table>();
+
+        for (const auto &row : *rows)
+            table->push_back(std::make_shared<T>(*row));
+
+        rows = table;
+    }
+
+    const_iterator begin() const {
+        return const_iterator(rows->begin());
+    }
+
+    const_iterator end() const {
+        return const_iterator(rows->end());
+    }
+
+    std::vector<T> unpack() const {
+        std::vector<T> values;
+
+        for (const auto &row : *rows)
+            values.push_back(*row);
+
+        return values;
+    }
+private:
+    Table& getTable() {
+        if (rows.use_count() > 1)
+            rows = std::make_shared<Table>(*rows);
+
+        return *rows;
+    }
+};
+
+// vector shared between copies as a whole, the first modification of a shared vector copies it
+template <typename T>
+class SharedVector {
+    std::shared_ptr<std::vector<T>> values;
+public:
+    SharedVector() : values(std::make_shared<std::vector<T>>()) {
+    }
+
+    SharedVector(const std::vector<T> &values) : values(std::make_shared<std::vector<T>>(values)) {
+    }
+
+    size_t size() const {
+        return values->size();
+    }
+
+    const T& operator[](size_t index) const {
+        return (*values)[index];
+    }
+
+    typename std::vector<T>::const_iterator begin() const {
+        return values->begin();
+    }
+
+    typename std::vector<T>::const_iterator end() const {
+        return values->end();
+    }
+
+    const std::vector<T>& get() const {
+        return *values;
+    }
+
+    T& modify(size_t index) {
+        return getValues()[index];
+    }
+
+    void push_back(const T &value) {
+        getValues().push_back(value);
+    }
+
+    void unshare() {
+        values = std::make_shared<std::vector<T>>(*values);
+    }
+private:
+    std::vector<T>& getValues() {
+        if (values.use_count() > 1)
+            values = std::make_shared<std::vector<T>>(*values);
+
+        return *values;
+    }
+};
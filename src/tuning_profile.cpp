@@ -0,0 +1,84 @@
+#include "tuning_profile.h"
+
+bool TuningProfile::read(const std::string &path) {
+    std::ifstream f(path);
+    if (!f)
+        return false;
+
+    std::string line;
+    std::string name;
+    classes.clear();
+    comments.clear();
+
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#')
+            continue;
+
+        if (line[0] == '[') {
+            size_t end = line.find(']');
+            if (end == std::string::npos)
+                return false;
+
+            name = line.substr(1, end - 1);
+            classes[name].clear();
+            continue;
+        }
+
+        std::stringstream ss(line);
+        std::string option;
+        std::string value;
+
+        if (name.empty() || !(ss >> option >> value))
+            return false;
+
+        classes[name].push_back({option, value});
+    }
+
+    return true;
+}
+
+bool TuningProfile::write(const std::string &path) const {
+    std::ofstream f(path);
+    if (!f)
+        return false;
+
+    for (const auto &it : classes) {
+        auto comment = comments.find(it.first);
+        if (comment != comments.end() && !comment->second.empty())
+            f << "# " << comment->second << std::endl;
+
+        f << "[" << it.first << "]" << std::endl;
+
+        for (const auto &option : it.second)
+            f << option.first << " " << option.second << std::endl;
+
+        f << std::endl;
+    }
+
+    return true;
+}
+
+void TuningProfile::set(const std::string &name, const ProfileOptions &options, const std::string &comment) {
+    classes[name] = options;
+    comments[name] = comment;
+}
+
+bool TuningProfile::get(const std::string &name, ProfileOptions &options) const {
+    auto it = classes.find(name);
+    if (it == classes.end())
+        return false;
+
+    options = it->second;
+    return true;
+}
+
+std::string TuningProfile::getClass(int rank) {
+    // rows of W range over all products, so the rank sets the cost of reduction steps
+    const int bounds[] = {32, 128, 512};
+
+    for (int bound : bounds)
+        if (rank <= bound)
+            return "rank<=" + std::to_string(bound);
+
+    return "rank>512";
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+
+typedef std::vector<std::pair<std::string, std::string>> ProfileOptions;
+
+// recommended command line options per class of schemes, written by the tuning tool and read by the reducer,
+// text format: "[class]" line followed by "--option value" lines, "#" starts a comment
+class TuningProfile {
+    std::map<std::string, ProfileOptions> classes;
+    std::map<std::string, std::string> comments;
+public:
+    bool read(const std::string &path);
+    bool write(const std::string &path) const;
+
+    void set(const std::string &name, const ProfileOptions &options, const std::string &comment = "");
+    bool get(const std::string &name, ProfileOptions &options) const;
+
+    static std::string getClass(int rank);
+};
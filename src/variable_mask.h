@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+#include <cstdlib>
+
+// signed variables of one expression as two bitsets of fixed width (positive, then negative words), variable k is bit k - 1,
+// fixed number of words lets the compiler unroll loops and replace hash lookups by shifts
+template <int Words>
+struct VariableMask {
+    static constexpr int size = 2 * Words;
+    static constexpr int maxVariable = 64 * Words;
+
+    static void clear(uint64_t *mask) {
+        for (int i = 0; i < size; i++)
+            mask[i] = 0;
+    }
+
+    static void insert(uint64_t *mask, int variable) {
+        int bit = abs(variable) - 1;
+        mask[(variable < 0) * Words + (bit >> 6)] |= uint64_t(1) << (bit & 63);
+    }
+
+    static void erase(uint64_t *mask, int variable) {
+        int bit = abs(variable) - 1;
+        mask[(variable < 0) * Words + (bit >> 6)] &= ~(uint64_t(1) << (bit & 63));
+    }
+
+    static uint64_t get(const uint64_t *mask, int variable) {
+        int bit = abs(variable) - 1;
+        return (mask[(variable < 0) * Words + (bit >> 6)] >> (bit & 63)) & 1;
+    }
+
+    // number of words per expression for the maximum variable, 0 if it does not fit the widest mask
+    static int getWords(int maxVariable) {
+        for (int words = 1; words <= Words; words *= 2)
+            if (64 * words >= maxVariable)
+                return words;
+
+        return 0;
+    }
+};
+
+// widest specialization, larger schemes use hash lookups of the expressions
+typedef VariableMask<8> WidestVariableMask;
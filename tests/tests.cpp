@@ -0,0 +1,509 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <map>
+#include <random>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <unistd.h>
+#include <omp.h>
+
+#include "../src/arg_parser.h"
+#include "../src/addition_reducer.h"
+#include "../src/exact_reducer.h"
+#include "../src/best_exchange.h"
+#include "../src/reducer_options.h"
+#include "../src/reducer_run.h"
+#include "../src/tuning_profile.h"
+
+typedef std::vector<std::vector<int>> Rows;
+
+// random component of ternary rows with at least two variables in every row
+AdditionReducer getComponent(RandomGenerator &generator, int rows, int variables) {
+    std::uniform_int_distribution<int> coefficient(-1, 1);
+    AdditionReducer reducer;
+
+    for (int row = 0; row < rows; row++) {
+        std::vector<int> expression(variables, 0);
+        int nonzeros = 0;
+
+        while (nonzeros < 2) {
+            nonzeros = 0;
+
+            for (int &value : expression) {
+                value = coefficient(generator);
+                nonzeros += value != 0;
+            }
+        }
+
+        reducer.addExpression(expression);
+    }
+
+    return reducer;
+}
+
+Rows getRows(const AdditionReducer &reducer) {
+    Rows rows;
+
+    for (const auto &expression : reducer.getExpressions()) {
+        std::vector<int> row(expression.begin(), expression.end());
+        std::sort(row.begin(), row.end());
+        rows.push_back(row);
+    }
+
+    return rows;
+}
+
+// exhaustive search over all sequences of repeated pairs, written without the reducer code
+int getOptimalAdditions(const Rows &rows, int variables, int fresh, std::map<Rows, int> &memo) {
+    auto it = memo.find(rows);
+    if (it != memo.end())
+        return it->second + fresh;
+
+    std::map<std::pair<int, int>, int> counts;
+
+    for (const auto &row : rows) {
+        for (size_t k1 = 0; k1 < row.size(); k1++) {
+            for (size_t k2 = 0; k2 < row.size(); k2++) {
+                int i = row[k1];
+                int j = row[k2];
+
+                if (abs(i) >= abs(j))
+                    continue;
+
+                counts[i > 0 ? std::make_pair(i, j) : std::make_pair(-i, -j)]++;
+            }
+        }
+    }
+
+    int additions = fresh;
+    for (const auto &row : rows)
+        additions += row.size() - 1;
+
+    for (const auto &count : counts) {
+        if (count.second < 2)
+            continue;
+
+        int i = count.first.first;
+        int j = count.first.second;
+        int variable = variables + fresh + 1;
+        Rows replaced = rows;
+
+        for (auto &row : replaced) {
+            for (int sign = 1; sign >= -1; sign -= 2) {
+                auto it1 = std::find(row.begin(), row.end(), i * sign);
+                auto it2 = std::find(row.begin(), row.end(), j * sign);
+
+                if (it1 == row.end() || it2 == row.end())
+                    continue;
+
+                row.erase(std::find(row.begin(), row.end(), i * sign));
+                row.erase(std::find(row.begin(), row.end(), j * sign));
+                row.push_back(variable * sign);
+                std::sort(row.begin(), row.end());
+            }
+        }
+
+        additions = std::min(additions, getOptimalAdditions(replaced, variables, fresh + 1, memo));
+    }
+
+    memo[rows] = additions - fresh;
+    return additions;
+}
+
+// the optimality proof of exact search must give the same additions as the exhaustive search
+bool testExactSearch(RandomGenerator &generator, int components) {
+    std::uniform_int_distribution<int> rowsDistribution(3, 6);
+    std::uniform_int_distribution<int> variablesDistribution(3, 5);
+    int proven = 0;
+
+    for (int component = 0; component < components; component++) {
+        int variables = variablesDistribution(generator);
+        AdditionReducer initial = getComponent(generator, rowsDistribution(generator), variables);
+
+        AdditionReducer incumbent;
+        incumbent.copyFrom(initial);
+        incumbent.setStrategy(Strategy::GreedyRandom);
+        incumbent.reduce(generator);
+
+        ExactReducer exact(1000000);
+        if (!exact.solve(initial, incumbent))
+            continue;
+
+        std::map<Rows, int> memo;
+        int optimal = getOptimalAdditions(getRows(initial), variables, 0, memo);
+        proven++;
+
+        if (exact.getBest().getAdditions() != optimal) {
+            std::cout << "- exact search: FAILED, component " << component << " is proven with " << exact.getBest().getAdditions() << " additions, optimal is " << optimal << std::endl;
+            return false;
+        }
+    }
+
+    std::cout << "- exact search: ok (" << proven << " of " << components << " components proven, all optimal)" << std::endl;
+    return true;
+}
+
+// a sequence reduced with one row storage gives the same rows when it is replayed with the other one,
+// and the other storage finds no repeated pair after it, so both storages count the same pairs
+bool testRowStorages(RandomGenerator &generator, int components) {
+    std::uniform_int_distribution<int> rowsDistribution(8, 32);
+    std::uniform_int_distribution<int> variablesDistribution(6, 16);
+    RowStorage storages[] = {RowStorage::Dense, RowStorage::Sparse};
+
+    for (int component = 0; component < components; component++) {
+        AdditionReducer initial = getComponent(generator, rowsDistribution(generator), variablesDistribution(generator));
+
+        for (int k = 0; k < 2; k++) {
+            AdditionReducer source;
+            source.copyFrom(initial);
+            source.setRowStorage(storages[k]);
+            source.setStrategy(Strategy::GreedyRandom);
+            source.reduce(generator);
+
+            AdditionReducer target;
+            target.copyFrom(initial);
+            target.setRowStorage(storages[1 - k]);
+
+            if (source.isSparse() == target.isSparse() || !target.applyFreshVariables(source.getFreshVariables())) {
+                std::cout << "- row storages: FAILED, component " << component << " is not replayed with the other storage" << std::endl;
+                return false;
+            }
+
+            if (getRows(source) != getRows(target) || source.getAdditions() != target.getAdditions()) {
+                std::cout << "- row storages: FAILED, component " << component << " has other rows after replay with the other storage" << std::endl;
+                return false;
+            }
+
+            target.setStrategy(Strategy::Greedy);
+            target.reduce(generator);
+
+            if (target.getFreshVars() != source.getFreshVars()) {
+                std::cout << "- row storages: FAILED, component " << component << " has repeated pairs only in " << (target.isSparse() ? "sparse" : "dense") << " storage" << std::endl;
+                return false;
+            }
+        }
+    }
+
+    std::cout << "- row storages: ok (" << components << " components reduced with dense and sparse rows)" << std::endl;
+    return true;
+}
+
+// a sequence published by one reducer is read back from the exchange directory and replayed by another reducer with the same rows,
+// a record with more fresh variables than the reading component allows is rejected before it is allocated
+bool testExchange(RandomGenerator &generator, int components) {
+    std::uniform_int_distribution<int> rowsDistribution(8, 32);
+    std::uniform_int_distribution<int> variablesDistribution(6, 16);
+
+    char directory[] = "/tmp/ternary_addition_reducer_test_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cout << "- exchange: FAILED, unable to create temporary directory" << std::endl;
+        return false;
+    }
+
+    DirectoryExchange exchange(directory);
+    std::string name = "component";
+    bool correct = true;
+
+    for (int component = 0; component < components && correct; component++) {
+        AdditionReducer initial = getComponent(generator, rowsDistribution(generator), variablesDistribution(generator));
+
+        AdditionReducer source;
+        source.copyFrom(initial);
+        source.setStrategy(Strategy::GreedyRandom);
+        source.reduce(generator);
+
+        ExchangeRecord record;
+        std::vector<ExchangeRecord> records;
+
+        if (!exchange.publish(name, {"source", source.getAdditions(), source.getFreshVars(), source.getFreshVariables()}) || !exchange.store(name, {"source", source.getAdditions(), source.getFreshVars(), source.getFreshVariables()})) {
+            std::cout << "- exchange: FAILED, unable to write records of component " << component << std::endl;
+            correct = false;
+        }
+        else if (!exchange.pull(name, record, initial.getNaiveAdditions()) || (records = exchange.collect(name, initial.getNaiveAdditions())).size() != 1 || records[0].freshVariables != record.freshVariables) {
+            std::cout << "- exchange: FAILED, records of component " << component << " are not read back" << std::endl;
+            correct = false;
+        }
+        else if (source.getFreshVars() > 0 && (exchange.pull(name, record, source.getFreshVars() - 1) || !exchange.collect(name, source.getFreshVars() - 1).empty())) {
+            std::cout << "- exchange: FAILED, record of component " << component << " with too many fresh variables is accepted" << std::endl;
+            correct = false;
+        }
+        else {
+            AdditionReducer target;
+            target.copyFrom(initial);
+
+            if (!target.applyFreshVariables(records[0].freshVariables) || getRows(source) != getRows(target) || target.getAdditions() != records[0].additions || target.getFreshVars() != records[0].freshVars) {
+                std::cout << "- exchange: FAILED, record of component " << component << " is not replayed to the same rows" << std::endl;
+                correct = false;
+            }
+        }
+
+        std::remove((std::string(directory) + "/" + name + "_worker_source.txt").c_str());
+        std::remove((std::string(directory) + "/" + name + "_best.txt").c_str());
+    }
+
+    rmdir(directory);
+
+    if (correct)
+        std::cout << "- exchange: ok (" << components << " sequences replayed from records)" << std::endl;
+
+    return correct;
+}
+
+// runs the reducer with command line arguments as a plain run, messages of the parser and the run go to os
+int runArgs(std::vector<std::string> args, std::ostream &os) {
+    std::vector<char *> argv;
+    for (auto &arg : args)
+        argv.push_back(&arg[0]);
+
+    ArgParser parser("ternary_addition_reducer");
+    addArguments(parser);
+    parser.setOutput(os);
+
+    if (!parser.parse(argv.size(), argv.data()))
+        return -1;
+
+    std::stringstream input;
+    return runReducer(parser, input, os);
+}
+
+// saved schemes with the schemes they are reduced from are taken from the output of the reducer,
+// schemes of promoted orbit variants are saved before their reductions
+std::vector<std::pair<std::string, std::string>> getSavedPaths(const std::string &log, const std::string &scheme, std::vector<std::string> &variants) {
+    std::vector<std::pair<std::string, std::string>> paths;
+    std::stringstream ss(log);
+    std::string line;
+    std::string current = scheme;
+    std::string savedPrefix = "Reduced scheme saved to \"";
+    std::string variantPrefix = "Orbit variant ";
+    std::string variantSaved = " saved to \"";
+    std::string promotedPrefix = "Promoted orbit variant 0 ";
+
+    while (std::getline(ss, line)) {
+        size_t position = line.find(variantSaved);
+
+        if (line.compare(0, savedPrefix.size(), savedPrefix) == 0) {
+            paths.push_back({line.substr(savedPrefix.size(), line.size() - savedPrefix.size() - 1), current});
+        }
+        else if (line.compare(0, variantPrefix.size(), variantPrefix) == 0 && position != std::string::npos) {
+            current = line.substr(position + variantSaved.size(), line.size() - position - variantSaved.size() - 1);
+            variants.push_back(current);
+        }
+        else if (line.compare(0, promotedPrefix.size(), promotedPrefix) == 0) {
+            current = scheme;
+        }
+    }
+
+    return paths;
+}
+
+// every scheme saved by the reducer passes the verify mode with the scheme it is reduced from, the reducer runs from command line options as a plain run
+bool testSavedSchemes(const std::vector<std::string> &schemes, int seed) {
+    char directory[] = "/tmp/ternary_addition_reducer_test_XXXXXX";
+    if (!mkdtemp(directory)) {
+        std::cout << "- saved schemes: FAILED, unable to create temporary directory" << std::endl;
+        return false;
+    }
+
+    // every class of schemes is tuned, so the options of the profile are used for any scheme
+    TuningProfile profile;
+    std::string profilePath = std::string(directory) + "/profile.txt";
+
+    for (int rank : {32, 128, 512, 513})
+        profile.set(TuningProfile::getClass(rank), {{"--count", "4"}, {"--local-search-steps", "5"}, {"--gp-weight", "0.1"}});
+
+    if (!profile.write(profilePath)) {
+        std::cout << "- saved schemes: FAILED, unable to write tuning profile" << std::endl;
+        rmdir(directory);
+        return false;
+    }
+
+    std::vector<std::vector<std::string>> configs = {
+        {},
+        {"--duplicates", "1", "--symmetry", "1"},
+        {"--row-storage", "sparse", "--local-search-steps", "10"},
+        {"--row-storage", "auto", "--reducer-tasks", "2"},
+        {"--compact", "1", "--fork-count", "4"},
+        {"--crossover-rate", "0.5", "--exact-max-nodes", "10000"},
+        {"--orbit-variants", "2", "--orbit-count", "4", "--orbit-promote", "2"},
+        {"--bs-weight", "0.5", "--beam-width", "2"},
+        {"--profile", profilePath}
+    };
+
+    bool correct = true;
+    int saved = 0;
+
+    for (const auto &scheme : schemes) {
+        for (const auto &config : configs) {
+            std::vector<std::string> args = {"ternary_addition_reducer", "-o", directory, "--seed", std::to_string(seed), "--max-no-improvements", "1", "--verify-saves", "0"};
+            args.insert(args.end(), config.begin(), config.end());
+
+            std::vector<std::string> reduceArgs = args;
+            reduceArgs.insert(reduceArgs.end(), {"-i", scheme});
+
+            std::stringstream log;
+            std::vector<std::string> variants;
+
+            if (runArgs(reduceArgs, log) != 0) {
+                std::cout << "- saved schemes: FAILED, unable to reduce \"" << scheme << "\": " << log.str();
+                correct = false;
+                break;
+            }
+
+            if (log.str().find("(not tuned)") != std::string::npos) {
+                std::cout << "- saved schemes: FAILED, tuning profile is not applied to \"" << scheme << "\"" << std::endl;
+                correct = false;
+                break;
+            }
+
+            std::vector<std::pair<std::string, std::string>> paths = getSavedPaths(log.str(), scheme, variants);
+            if (paths.empty()) {
+                std::cout << "- saved schemes: FAILED, nothing is saved for \"" << scheme << "\" with options";
+                for (const auto &arg : config)
+                    std::cout << " " << arg;
+                std::cout << std::endl;
+                correct = false;
+            }
+
+            for (const auto &path : paths) {
+                std::vector<std::string> verifyArgs = args;
+                verifyArgs.insert(verifyArgs.end(), {"-i", path.second, "--mode", "verify", "--reduced", path.first});
+
+                std::stringstream verifyLog;
+                if (runArgs(verifyArgs, verifyLog) != 0) {
+                    std::cout << "- saved schemes: FAILED, \"" << path.first << "\" is invalid: " << verifyLog.str();
+                    correct = false;
+                }
+
+                std::remove(path.first.c_str());
+                saved++;
+            }
+
+            for (const auto &variant : variants)
+                std::remove(variant.c_str());
+
+            if (!correct)
+                break;
+        }
+
+        if (!correct)
+            break;
+    }
+
+    std::remove(profilePath.c_str());
+    rmdir(directory);
+
+    if (correct)
+        std::cout << "- saved schemes: ok (" << saved << " saved schemes are valid)" << std::endl;
+
+    return correct;
+}
+
+// random streams of reducers are fixed by the seed and the task, so a reduction with the same seed and options
+// gives the same best scheme with any number of threads
+bool testThreads(const std::vector<std::string> &schemes, int seed, int threads) {
+    std::vector<std::vector<std::string>> configs = {
+        {},
+        {"--reducer-tasks", "2", "--local-search-steps", "10"},
+        {"--crossover-rate", "0.5", "--fork-count", "4"}
+    };
+
+    int maxThreads = omp_get_max_threads();
+    bool correct = true;
+    int runs = 0;
+
+    for (const auto &scheme : schemes) {
+        for (const auto &config : configs) {
+            std::vector<std::string> args = {"ternary_addition_reducer", "-i", scheme, "--max-no-improvements", "3"};
+            args.insert(args.end(), config.begin(), config.end());
+
+            std::vector<char *> argv;
+            for (auto &arg : args)
+                argv.push_back(&arg[0]);
+
+            ArgParser parser("ternary_addition_reducer");
+            addArguments(parser);
+            parser.parse(argv.size(), argv.data());
+
+            std::pair<int, int> costs[2];
+
+            for (int k = 0; k < 2; k++) {
+                omp_set_num_threads(k == 0 ? 1 : threads);
+
+                std::stringstream log;
+                std::ifstream f(scheme);
+                SchemeReducer reducer(std::stoi(parser.get("--count")), "", getStrategyWeights(parser), seed);
+                reducer.setOutput(log);
+                reducer.setSaving(false);
+                prepareReducer(parser, reducer);
+
+                if (!reducer.initialize(f)) {
+                    std::cout << "- threads: FAILED, unable to read scheme \"" << scheme << "\"" << std::endl;
+                    omp_set_num_threads(maxThreads);
+                    return false;
+                }
+
+                configureReducer(parser, reducer);
+                reducer.reduce(std::stoi(parser.get("--max-no-improvements")), 0, std::stod(parser.get("--part-initialization-rate")), 1);
+                costs[k] = {reducer.getReducedAdditions(), reducer.getReducedFreshVars()};
+            }
+
+            if (costs[0] != costs[1]) {
+                std::cout << "- threads: FAILED, \"" << scheme << "\" with options";
+                for (const auto &arg : config)
+                    std::cout << " " << arg;
+                std::cout << " is reduced to " << costs[0].first << " additions with 1 thread and to " << costs[1].first << " with " << threads << " threads" << std::endl;
+                correct = false;
+            }
+
+            runs++;
+        }
+    }
+
+    omp_set_num_threads(maxThreads);
+
+    if (correct)
+        std::cout << "- threads: ok (" << runs << " reductions are the same with 1 and " << threads << " threads)" << std::endl;
+
+    return correct;
+}
+
+int main(int argc, char *argv[]) {
+    ArgParser parser("ternary_addition_reducer_test", "Check reducers against brute force and reference implementations on small random components");
+
+    parser.add("--components", ArgType::Natural, "INT", "number of random components per check", "3000");
+    parser.add("--schemes", ArgType::String, "PATHS", "comma separated paths to schemes reduced and saved for verification", "bench/schemes/3x3x3_m23.txt,bench/schemes/4x4x4_m49.txt");
+    parser.add("--seed", ArgType::Natural, "INT", "random seed", "1");
+    parser.add("--threads", ArgType::Natural, "INT", "number of threads compared with a single thread", "4");
+
+    if (!parser.parse(argc, argv))
+        return 0;
+
+    int components = std::stoi(parser.get("--components"));
+    int seed = std::stoi(parser.get("--seed"));
+    int threads = std::stoi(parser.get("--threads"));
+
+    std::vector<std::string> schemes;
+    std::stringstream ss(parser.get("--schemes"));
+    std::string scheme;
+
+    while (std::getline(ss, scheme, ','))
+        if (scheme != "")
+            schemes.push_back(scheme);
+
+    RandomGenerator generator(seed);
+    bool correct = true;
+
+    std::cout << "Run checks with seed " << seed << ":" << std::endl;
+    correct &= testExactSearch(generator, components);
+    correct &= testRowStorages(generator, components);
+    correct &= testExchange(generator, components);
+    correct &= testSavedSchemes(schemes, seed);
+    correct &= testThreads(schemes, seed, threads);
+
+    std::cout << (correct ? "All checks passed" : "Some checks failed") << std::endl;
+    return correct ? 0 : 1;
+}